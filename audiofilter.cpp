@@ -0,0 +1,157 @@
+#include "audiofilter.h"
+#include <QDebug>
+
+extern "C" {
+#include <libavutil/opt.h>
+#include <libavutil/channel_layout.h>
+}
+
+AudioFilterGraph::AudioFilterGraph()
+{
+}
+
+AudioFilterGraph::~AudioFilterGraph()
+{
+    release();
+}
+
+QString AudioFilterGraph::presetChain(const QString &nameOrChain)
+{
+    QString name = nameOrChain.trimmed();
+
+    if (name == "eq") {
+        // 低频、人声、高频三段均衡
+        return "equalizer=f=100:t=q:w=1.0:g=3,"
+               "equalizer=f=2500:t=q:w=1.0:g=2,"
+               "equalizer=f=10000:t=q:w=1.0:g=1";
+    }
+    if (name == "night") {
+        // 夜间模式：压缩动态范围，小声更清楚、大声不吓人
+        return "acompressor=threshold=0.089:ratio=6:attack=10:release=200:makeup=4";
+    }
+    if (name == "loudnorm") {
+        // EBU R128 响度归一化
+        return "loudnorm=I=-16:TP=-1.5:LRA=11";
+    }
+    return name;
+}
+
+bool AudioFilterGraph::init(const QString &filters, int sampleRate, AVSampleFormat sampleFmt,
+                            int64_t channelLayout, AVRational timeBase)
+{
+    release();
+
+    QString chain = presetChain(filters);
+    if (chain.isEmpty()) {
+        return false;
+    }
+
+    m_graph = avfilter_graph_alloc();
+    if (!m_graph) {
+        return false;
+    }
+
+    char args[256];
+    snprintf(args, sizeof(args),
+             "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%llx",
+             timeBase.num, timeBase.den, sampleRate,
+             av_get_sample_fmt_name(sampleFmt), (unsigned long long)channelLayout);
+
+    int ret = avfilter_graph_create_filter(&m_src, avfilter_get_by_name("abuffer"),
+                                           "in", args, nullptr, m_graph);
+    if (ret < 0) {
+        qDebug() << "创建音频滤镜输入失败";
+        release();
+        return false;
+    }
+
+    ret = avfilter_graph_create_filter(&m_sink, avfilter_get_by_name("abuffersink"),
+                                       "out", nullptr, nullptr, m_graph);
+    if (ret < 0) {
+        qDebug() << "创建音频滤镜输出失败";
+        release();
+        return false;
+    }
+
+    // 输出参数和输入一致（loudnorm等会升采样，这里让滤镜图自动转回来）
+    const enum AVSampleFormat sampleFmts[] = { sampleFmt, AV_SAMPLE_FMT_NONE };
+    const int64_t channelLayouts[] = { channelLayout, -1 };
+    const int sampleRates[] = { sampleRate, -1 };
+    av_opt_set_int_list(m_sink, "sample_fmts", sampleFmts, AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
+    av_opt_set_int_list(m_sink, "channel_layouts", channelLayouts, -1, AV_OPT_SEARCH_CHILDREN);
+    av_opt_set_int_list(m_sink, "sample_rates", sampleRates, -1, AV_OPT_SEARCH_CHILDREN);
+
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    if (!outputs || !inputs) {
+        avfilter_inout_free(&outputs);
+        avfilter_inout_free(&inputs);
+        release();
+        return false;
+    }
+
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = m_src;
+    outputs->pad_idx = 0;
+    outputs->next = nullptr;
+
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = m_sink;
+    inputs->pad_idx = 0;
+    inputs->next = nullptr;
+
+    ret = avfilter_graph_parse_ptr(m_graph, chain.toUtf8().constData(),
+                                   &inputs, &outputs, nullptr);
+    avfilter_inout_free(&outputs);
+    avfilter_inout_free(&inputs);
+    if (ret < 0) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        qDebug() << "解析音频滤镜失败:" << chain << errbuf;
+        release();
+        return false;
+    }
+
+    ret = avfilter_graph_config(m_graph, nullptr);
+    if (ret < 0) {
+        qDebug() << "配置音频滤镜图失败:" << chain;
+        release();
+        return false;
+    }
+
+    m_description = filters;
+    m_outputTimeBase = av_buffersink_get_time_base(m_sink);
+    qDebug() << "音频滤镜已启用:" << chain;
+    return true;
+}
+
+void AudioFilterGraph::release()
+{
+    if (m_graph) {
+        avfilter_graph_free(&m_graph);
+    }
+    m_src = nullptr;
+    m_sink = nullptr;
+    m_description.clear();
+}
+
+int AudioFilterGraph::sendFrame(AVFrame *frame)
+{
+    if (!isActive()) {
+        return AVERROR(EINVAL);
+    }
+
+    int ret = av_buffersrc_add_frame_flags(m_src, frame, 0);
+    if (frame) {
+        av_frame_unref(frame);
+    }
+    return ret;
+}
+
+int AudioFilterGraph::receiveFrame(AVFrame *frame)
+{
+    if (!isActive()) {
+        return AVERROR(EINVAL);
+    }
+    return av_buffersink_get_frame(m_sink, frame);
+}
@@ -0,0 +1,46 @@
+#ifndef AUDIOFILTER_H
+#define AUDIOFILTER_H
+
+#include <QString>
+
+extern "C" {
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersrc.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/frame.h>
+#include <libavutil/samplefmt.h>
+}
+
+// 解码之后的音频滤镜阶段：abuffer → 滤镜链 → abuffersink
+// 输出的采样率/格式/声道与输入保持一致，后面的重采样器不用跟着重建
+class AudioFilterGraph
+{
+public:
+    AudioFilterGraph();
+    ~AudioFilterGraph();
+
+    bool init(const QString &filters, int sampleRate, AVSampleFormat sampleFmt,
+              int64_t channelLayout, AVRational timeBase);
+    void release();
+
+    bool isActive() const { return m_graph != nullptr; }
+    QString description() const { return m_description; }
+    AVRational outputTimeBase() const { return m_outputTimeBase; }
+
+    // 送入一帧（接管引用）；frame为nullptr表示输入结束，把滤镜内部缓存的数据冲出来
+    int sendFrame(AVFrame *frame);
+    // 取出一帧，AVERROR(EAGAIN)表示暂时没有输出，AVERROR_EOF表示已冲刷完
+    int receiveFrame(AVFrame *frame);
+
+    // 预设名转滤镜链："eq"、"night"、"loudnorm"，其它字符串原样当作滤镜链
+    static QString presetChain(const QString &nameOrChain);
+
+private:
+    AVFilterGraph *m_graph = nullptr;
+    AVFilterContext *m_src = nullptr;
+    AVFilterContext *m_sink = nullptr;
+    QString m_description;
+    AVRational m_outputTimeBase = {0, 1};
+};
+
+#endif // AUDIOFILTER_H
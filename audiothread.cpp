@@ -1,10 +1,20 @@
 #include "audiothread.h"
+#include "playbackstats.h"
+#include "memorybudget.h"
 #include <QDebug>
 #include <QElapsedTimer>
-#include <QDateTime>
+#include <cstring>
+
+// PCM队列目标水位（毫秒），生产者保持队列里至少有这么多数据
+static const int AUDIO_QUEUE_MS = 200;
 
 AudioThread::AudioThread(QObject *parent) : QObject(parent)
 {
+    // 定时器随对象一起移到音频线程，解码在音频线程完成
+    m_producerTimer = new QTimer(this);
+    connect(m_producerTimer, &QTimer::timeout, this, &AudioThread::fillPcmQueue);
+
+    m_audioFilterDesc = PlayerConfig::audioFilters;
     qDebug() << "AudioThread 创建";
 }
 
@@ -22,22 +32,32 @@ double AudioThread::getCurrentTime() const
     return m_audioClock;
 }
 
+void AudioThread::setOutputTap(AudioTap *tap)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputTap = tap;
+}
+
 void AudioThread::init_audio(const QString &filename)
 {
     qDebug() << "初始化音频:" << filename;
 
     // 清理之前的资源
     cleanup();
+    m_currentFile = filename;
+    updateReplayGain();
 
     // 初始化音频解码器
     if (!initAudioDecoder(filename)) {
         emit errorOccurred("音频解码器初始化失败");
+        emit prerolled();
         return;
     }
 
     // 初始化SDL音频输出
     if (!initSDLOutput()) {
         emit errorOccurred("SDL音频输出初始化失败");
+        emit prerolled();
         return;
     }
 
@@ -45,10 +65,13 @@ void AudioThread::init_audio(const QString &filename)
     m_isPlaying = false;
     m_isEOF = false;
     m_audioClock = 0.0;
-    m_startTime = 0;
 
-    qDebug() << "音频初始化完成，准备播放";
-    startPlayback();
+    // 先把队列填到预读水位，由播放引擎等视频也准备好后一起开始
+    fillPcmQueueTo(qMax(AUDIO_QUEUE_MS, PlayerConfig::prerollMs));
+    m_producerTimer->start(10);
+
+    qDebug() << "音频初始化完成，预读" << queuedPcmBytes() << "字节";
+    emit prerolled();
 }
 
 bool AudioThread::initAudioDecoder(const QString &filename)
@@ -145,14 +168,21 @@ bool AudioThread::initAudioDecoder(const QString &filename)
         return false;
     }
 
-    // 11. 分配帧和包
+    // 11. 分配帧、包和PCM队列
     m_frame = av_frame_alloc();
     m_packet = av_packet_alloc();
+    m_filterFrame = av_frame_alloc();
+    m_pcmQueue = av_fifo_alloc(m_sampleRate * m_channels * 2 * AUDIO_QUEUE_MS / 1000 * 2);
+    if (m_pcmQueue) {
+        MemoryBudget::charge(MemoryBudget::PcmQueue, av_fifo_space(m_pcmQueue));
+    }
+    allocateAudioBuffer(maxConvertedSamples());
 
-    if (!m_frame || !m_packet) {
+    if (!m_frame || !m_packet || !m_filterFrame || !m_pcmQueue) {
         qDebug() << "无法分配帧或包";
         return false;
     }
+    m_queueEndPts = 0.0;
 
     // 12. 预解码几帧填充缓冲区
     //    for (int i = 0; i < 3; i++) {
@@ -169,6 +199,15 @@ bool AudioThread::initSDLOutput()
 {
     qDebug() << "初始化SDL音频输出...";
 
+    // 离屏输出：换成SDL的dummy驱动，回调照常按实时节奏触发，只是不出声
+    if (PlayerConfig::audioOutput == "offscreen") {
+        const char *driver = SDL_GetCurrentAudioDriver();
+        if (!driver || strcmp(driver, "dummy") != 0) {
+            SDL_QuitSubSystem(SDL_INIT_AUDIO);
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        }
+    }
+
     // 检查SDL音频是否已初始化
     if (!SDL_WasInit(SDL_INIT_AUDIO)) {
         qDebug() << "警告：SDL音频子系统未初始化";
@@ -216,37 +255,12 @@ bool AudioThread::initSDLOutput()
     return true;
 }
 
-void AudioThread::UpadatStatus()
-{
-    switch (GlobalVars::playerState) {
-    case STATE_IDLE:
-        // 还没打开文件，先打开
-        //           if (openVideoFile()) {
-        //               startPlayback();
-        //           }
-        break;
-
-    case STATE_READY:
-        //    startPlayback();
-        break;
-
-    case STATE_PLAYING:
-        startPlayback();
-        break;
-
-    case STATE_PAUSED:
-        pausePlayback();
-        break;
-
-    case STATE_ENDED:
-        //       restartPlayback();
-        break;
-    }
-}
-
 void AudioThread::startPlayback()
 {
-    QMutexLocker locker(&m_mutex);
+    // 变速/跳转会清空队列，开始前补到预读水位（已经够了就什么都不做）
+    if (!m_isPlaying) {
+        fillPcmQueueTo(qMax(AUDIO_QUEUE_MS, PlayerConfig::prerollMs));
+    }
 
     if (m_audioDevice == 0) {
         qDebug() << "音频设备未初始化";
@@ -258,51 +272,103 @@ void AudioThread::startPlayback()
         return;
     }
 
+    // 时钟由updateAudioClock按队列换算（跳转时由seekAndRefill设置），这里不动
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isPlaying = true;
+    }
+    // 设备调用在锁外（同setSpeed）
+    SDL_PauseAudioDevice(m_audioDevice, m_fastForwardMuted ? 1 : 0);  // 0=开始播放，1=暂停（快进时保持静音）
 
-    m_audioClock = 0;
-    m_isPlaying = true;
-    m_startTime = QDateTime::currentMSecsSinceEpoch();
-    SDL_PauseAudioDevice(m_audioDevice, 0);  // 0=开始播放，1=暂停
-
-    qDebug() << "音频开始播放，开始时间:" << m_startTime;
+    qDebug() << "音频开始播放，当前时钟:" << m_audioClock << "秒";
 }
 
 void AudioThread::pausePlayback()
 {
-    QMutexLocker locker(&m_mutex);
-
     if (!m_isPlaying || m_audioDevice == 0) {
         return;
     }
 
-    m_isPlaying = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isPlaying = false;
+    }
+    // 设备正在回调，必须在锁外暂停
     SDL_PauseAudioDevice(m_audioDevice, 1);  // 暂停播放
 
-    // 更新音频时钟（暂停时不增加）
-    qint64 elapsed = QDateTime::currentMSecsSinceEpoch() - m_startTime;
-    m_audioClock += elapsed / 1000.0;
-    m_startTime = 0;
-
     qDebug() << "音频暂停，当前时钟:" << m_audioClock << "秒";
 }
 
 void AudioThread::stopPlayback()
 {
-    QMutexLocker locker(&m_mutex);
-
-    m_isPlaying = false;
-    m_isEOF = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isPlaying = false;
+        m_isEOF = false;
+    }
 
+    // 关闭设备会等回调结束，同样不能拿着锁
     if (m_audioDevice != 0) {
         SDL_PauseAudioDevice(m_audioDevice, 1);  // 先暂停
         SDL_CloseAudioDevice(m_audioDevice);     // 再关闭
         m_audioDevice = 0;
     }
 
-    m_startTime = 0;
     qDebug() << "音频停止";
 }
 
+void AudioThread::setAudioFilters(QString filters)
+{
+    filters = filters.trimmed();
+    if (filters == m_audioFilterDesc) {
+        return;
+    }
+
+    // 旧滤镜里还缓存着的数据先冲进队列，已缓冲的音频保持不动
+    int drained = drainAudioFilter();
+    m_audioFilterDesc = filters;
+    qDebug() << "音频滤镜改为:" << (filters.isEmpty() ? QString("无") : filters)
+             << "，旧滤镜冲刷" << drained << "字节";
+}
+
+void AudioThread::setLoop(qint64 startMs, qint64 endMs)
+{
+    m_loopStartMs = startMs;
+    m_loopEndMs = (startMs >= 0 && endMs > startMs) ? endMs : -1;
+
+    if (m_loopStartMs < 0 || !m_formatCtx) {
+        return;
+    }
+    if (m_loopEndMs >= 0 && m_queueEndPts > m_loopEndMs / 1000.0) {
+        // 队列里已经解到终点之后的部分不能再放出去
+        trimPcmQueue(m_loopEndMs / 1000.0);
+        loopBack();
+    } else if (m_isEOF && loopBack()) {
+        // 已经解到文件末尾才打开循环
+        m_isEOF = false;
+    }
+}
+
+void AudioThread::onLoudnessReady(QString filePath)
+{
+    if (filePath == m_currentFile) {
+        updateReplayGain();
+    }
+}
+
+void AudioThread::updateReplayGain()
+{
+    LoudnessInfo info;
+    float gain = 1.0f;
+    if (PlayerConfig::replayGain && LoudnessCache::instance().lookup(m_currentFile, &info)) {
+        gain = static_cast<float>(info.gainFor(PlayerConfig::replayGainTarget));
+        qDebug() << "响度增益:" << info.integratedLufs << "LUFS ->" << gain << "倍";
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_replayGain = gain;
+}
+
 void AudioThread::setVolume(float volume)
 {
     QMutexLocker locker(&m_mutex);
@@ -311,126 +377,168 @@ void AudioThread::setVolume(float volume)
 }
 
 // 修改重采样器参数来改变速度
+// 设备的暂停/恢复都在锁外做：SDL回调持有设备锁再拿m_mutex，反过来拿会死锁
 void AudioThread::setSpeed(float speed)
 {
-
-    QMutexLocker locker(&m_mutex);
+    // 2倍以上为快进：音频静音，快进结束后由视频线程通知跳转到新位置
+    if (speed > 2.0f) {
+        if (!m_fastForwardMuted) {
+            m_fastForwardMuted = true;
+            if (m_audioDevice) {
+                SDL_PauseAudioDevice(m_audioDevice, 1);
+            }
+            QMutexLocker locker(&m_mutex);
+            if (m_pcmQueue) {
+                av_fifo_reset(m_pcmQueue);
+            }
+            qDebug() << "快进" << speed << "x，音频静音";
+        }
+        return;
+    }
+    bool resume = false;
+    if (m_fastForwardMuted) {
+        m_fastForwardMuted = false;
+        resume = m_isPlaying && m_audioDevice;
+    }
 
     speed = qBound(0.5f, speed, 4.0f);
 
-    if (qFuzzyCompare(speed, m_speed)) return;
+    if (qFuzzyCompare(speed, m_speed)) {
+        if (resume) {
+            SDL_PauseAudioDevice(m_audioDevice, 0);
+        }
+        return;
+    }
 
     qDebug() << "🎵 音频变速: 从" << m_speed << "x改为" << speed << "x";
 
-    // 暂停播放
-    bool wasPlaying = m_isPlaying;
+    // 暂停播放；队列和解码器里是按旧速度的数据，重建后从当前时钟位置重新解码
+    bool wasPlaying = m_isPlaying && m_audioDevice;
     if (wasPlaying) {
         SDL_PauseAudioDevice(m_audioDevice, 1);
     }
+    qint64 positionMs = static_cast<qint64>(getCurrentTime() * 1000);
+    bool rebuilt = false;
 
-    // 清空缓冲区
-    freeAudioBuffer();
-    m_audioBufferLen = 0;
-    m_audioBufferIndex = 0;
-
-    // 清空解码器缓冲区
-    if (m_codecCtx) {
-        avcodec_flush_buffers(m_codecCtx);
-    }
-
-    // 保存新速度
-    float oldSpeed = m_speed;
-    m_speed = speed;
+    {
+        QMutexLocker locker(&m_mutex);
 
-    // 🔥 关键：销毁并重建重采样器
-    if (m_swrCtx) {
-        swr_free(&m_swrCtx);
-        m_swrCtx = nullptr;
-    }
+        // 清空缓冲区（队列里是按旧速度重采样的数据）
+        if (m_pcmQueue) {
+            av_fifo_reset(m_pcmQueue);
+        }
+        m_audioBufferLen = 0;
 
-    // 方法1：调整输入采样率（推荐）
-    // speed=2.0: 输入采样率*2，这样重采样器会"压缩"时间
-    // speed=0.5: 输入采样率/2，这样重采样器会"拉伸"时间
-    int inputSampleRate = static_cast<int>(m_sampleRate * speed);
+        // 清空解码器缓冲区
+        if (m_codecCtx) {
+            avcodec_flush_buffers(m_codecCtx);
+        }
 
-    m_swrCtx = swr_alloc_set_opts(nullptr,
-                                  m_audioChannelLayout,      // 输出声道
-                                  AV_SAMPLE_FMT_S16,         // 输出格式
-                                  m_sampleRate,              // 输出采样率（不变）
-                                  m_audioChannelLayout,      // 输入声道
-                                  m_sampleFmt,               // 输入格式
-                                  inputSampleRate,           // 🔥 输入采样率根据速度调整
-                                  0, nullptr);
+        // 保存新速度
+        float oldSpeed = m_speed;
+        m_speed = speed;
 
-    if (!m_swrCtx) {
-        qDebug() << "无法创建变速重采样器";
-        m_speed = oldSpeed;  // 恢复原速度
-        return;
-    }
+        // 🔥 关键：销毁并重建重采样器
+        if (m_swrCtx) {
+            swr_free(&m_swrCtx);
+            m_swrCtx = nullptr;
+        }
 
-    int ret = swr_init(m_swrCtx);
-    if (ret < 0) {
-        qDebug() << "无法初始化变速重采样器";
-        swr_free(&m_swrCtx);
-        m_speed = oldSpeed;
-        return;
+        // 方法1：调整输入采样率（推荐）
+        // speed=2.0: 输入采样率*2，这样重采样器会"压缩"时间
+        // speed=0.5: 输入采样率/2，这样重采样器会"拉伸"时间
+        int inputSampleRate = static_cast<int>(m_sampleRate * speed);
+
+        m_swrCtx = swr_alloc_set_opts(nullptr,
+                                      m_audioChannelLayout,      // 输出声道
+                                      AV_SAMPLE_FMT_S16,         // 输出格式
+                                      m_sampleRate,              // 输出采样率（不变）
+                                      m_audioChannelLayout,      // 输入声道
+                                      m_sampleFmt,               // 输入格式
+                                      inputSampleRate,           // 🔥 输入采样率根据速度调整
+                                      0, nullptr);
+
+        if (!m_swrCtx || swr_init(m_swrCtx) < 0) {
+            qDebug() << "无法创建变速重采样器";
+            swr_free(&m_swrCtx);
+            m_speed = oldSpeed;  // 恢复原速度
+        } else {
+            qDebug() << "✅ 音频变速设置成功: 速度" << speed << "x, 输入采样率:"
+                     << inputSampleRate << "Hz, 输出采样率:" << m_sampleRate << "Hz";
+            rebuilt = true;
+        }
     }
 
-    qDebug() << "✅ 音频变速设置成功: 速度" << speed << "x, 输入采样率:"
-             << inputSampleRate << "Hz, 输出采样率:" << m_sampleRate << "Hz";
-
-    // 需要重新定位（因为时间比例变了）
-    // 计算新的音频时钟
-    if (m_audioClock > 0) {
-        m_audioClock = m_audioClock * (oldSpeed / speed);
-        qDebug() << "音频时钟从" << m_audioClock * (speed / oldSpeed)
-                 << "s调整为" << m_audioClock << "s";
+    // 回到变速前的位置重新填队列（不丢掉预读的那一段），播放中的话填好后恢复设备
+    if (rebuilt) {
+        seekAndRefill(positionMs);
     }
 
     // 恢复播放
-    if (wasPlaying && m_audioDevice) {
+    if (wasPlaying || resume) {
         SDL_PauseAudioDevice(m_audioDevice, 0);
     }
-
 }
 
 void AudioThread::seekTo(qint64 positionMs)
 {
-    QMutexLocker locker(&m_mutex);
+    seekAndRefill(positionMs);
+    emit prerolled();
+}
 
-    if (!m_formatCtx || m_audioStreamIndex < 0) {
-        return;
+void AudioThread::seekAndRefill(qint64 positionMs)
+{
+    // 跳转期间停住设备，队列重新填到预读水位后再放（不在持锁时操作设备，回调里也要拿这把锁）
+    bool resume = m_isPlaying && m_audioDevice;
+    if (resume) {
+        SDL_PauseAudioDevice(m_audioDevice, 1);
     }
 
-    qDebug() << "音频跳转到:" << positionMs << "ms";
+    bool seeked = false;
+    {
+        QMutexLocker locker(&m_mutex);
 
-    // 1. 清空缓冲区
-    freeAudioBuffer();
-    m_audioBufferLen = 0;
-    m_audioBufferIndex = 0;
+        if (m_formatCtx && m_audioStreamIndex >= 0) {
+            qDebug() << "音频跳转到:" << positionMs << "ms";
 
-    // 2. 清除解码器缓冲区
-    avcodec_flush_buffers(m_codecCtx);
+            // 1. 清空缓冲区
+            if (m_pcmQueue) {
+                av_fifo_reset(m_pcmQueue);
+            }
+            m_audioBufferLen = 0;
 
-    // 3. 跳转
-    int64_t targetPts = av_rescale(positionMs, AV_TIME_BASE, 1000);
-    int ret = av_seek_frame(m_formatCtx, m_audioStreamIndex, targetPts, AVSEEK_FLAG_BACKWARD);
+            // 2. 清除解码器缓冲区（滤镜里的历史数据也不要了）
+            avcodec_flush_buffers(m_codecCtx);
+            m_audioFilter.release();
 
-    if (ret >= 0) {
-        m_audioClock = positionMs / 1000.0;
-        m_audioPts = m_audioClock;
-        m_isEOF = false;
+            // 3. 跳转
+            // 指定了流，时间戳用流的时间基
+            AVStream *stream = m_formatCtx->streams[m_audioStreamIndex];
+            int64_t targetPts = av_rescale_q(positionMs, AVRational{1, 1000}, stream->time_base);
+            int ret = av_seek_frame(m_formatCtx, m_audioStreamIndex, targetPts, AVSEEK_FLAG_BACKWARD);
 
-        // 预解码几帧填充缓冲区
-        for (int i = 0; i < 5; i++) {
-            if (!decodeAudioFrame()) {
-                break;
+            if (ret < 0) {
+                qDebug() << "音频跳转失败";
+            } else {
+                m_audioClock = positionMs / 1000.0;
+                m_audioPts = m_audioClock;
+                m_queueEndPts = m_audioClock;
+                m_isEOF = false;
+                m_loopSkipping = false;
+                m_loopTailBytes = 0;
+                seeked = true;
             }
         }
+    }
 
-        qDebug() << "音频跳转成功，新时钟:" << m_audioClock << "秒";
-    } else {
-        qDebug() << "音频跳转失败";
+    // 预解码填充队列（不持锁，写队列时再加锁）
+    if (seeked) {
+        fillPcmQueueTo(qMax(AUDIO_QUEUE_MS, PlayerConfig::prerollMs));
+        qDebug() << "音频跳转成功，新时钟:" << getCurrentTime() << "秒";
+    }
+
+    if (resume) {
+        SDL_PauseAudioDevice(m_audioDevice, m_fastForwardMuted ? 1 : 0);
     }
 }
 
@@ -449,59 +557,80 @@ void AudioThread::audioCallback(Uint8 *stream, int len)
     if (!m_isPlaying) {
         // 静音输出
         memset(stream, 0, len);
-        return;
-    }
-
-    if (m_isEOF && m_audioBufferLen == 0) {
+    } else if (m_isEOF && m_audioBufferLen == 0) {
         // 文件结束且缓冲区空，填充静音
         memset(stream, 0, len);
         emit playbackFinished();
-        return;
+    } else {
+        // 填充音频数据
+        fillAudioBuffer(stream, len);
     }
 
-    // 填充音频数据
-    fillAudioBuffer(stream, len);
+    // 离屏测量：看实际交给声卡的数据
+    if (m_outputTap) {
+        m_outputTap->played(stream, len, m_obtainedSpec.freq, m_obtainedSpec.channels);
+    }
 }
 
 void AudioThread::fillAudioBuffer(Uint8 *stream, int len)
 {
-    int filled = 0;
-
-    while (filled < len) {
-        // 如果缓冲区空，解码更多数据
-        if (m_audioBufferIndex >= m_audioBufferLen) {
-            if (!decodeAudioFrame()) {
-                // 解码失败或文件结束
-                if (m_isEOF) {
-                    // 文件结束，剩余部分填充静音
-                    memset(stream + filled, 0, len - filled);
-                    return;
-                }
-                // 解码失败但未到文件结束，继续尝试
-                continue;
-            }
+    // 回调里只拷贝队列数据，不解码
+    int copySize = qMin(av_fifo_size(m_pcmQueue), len);
+
+    if (copySize > 0) {
+        av_fifo_generic_read(m_pcmQueue, stream, copySize, nullptr);
+        m_loopTailBytes = qMax(0, m_loopTailBytes - copySize);
+
+        // 应用音量（叠加响度增益）
+        float gain = m_volume * m_replayGain;
+        if (gain != 1.0f) {
+            applyVolume(stream, copySize, gain);
         }
+    }
 
-        // 计算可以拷贝的数据量
-        int remainingBuffer = m_audioBufferLen - m_audioBufferIndex;
-        int remainingStream = len - filled;
-        int copySize = qMin(remainingBuffer, remainingStream);
+    if (copySize < len) {
+        // 生产者没跟上或文件结束，剩余部分填充静音
+        memset(stream + copySize, 0, len - copySize);
+        if (!m_isEOF) {
+            PlaybackStats::audioUnderruns.fetchAndAddRelaxed(1);
+        }
+    }
 
-        if (copySize > 0) {
-            // 关键修复：直接内存拷贝（交错格式）
-            memcpy(stream + filled,
-                   m_audioBuffer + m_audioBufferIndex,
-                   copySize);
+    int bytesPerSecond = m_sampleRate * m_channels * 2;
+    if (bytesPerSecond > 0) {
+        PlaybackStats::audioQueueMs.storeRelease(
+                    static_cast<int>(av_fifo_size(m_pcmQueue) * 1000LL / bytesPerSecond));
+    }
 
-            m_audioBufferIndex += copySize;
-            filled += copySize;
+    // 更新音频时钟
+    updateAudioClock(copySize);
+}
+
+void AudioThread::fillPcmQueue()
+{
+    fillPcmQueueTo(AUDIO_QUEUE_MS);
+}
+
+void AudioThread::fillPcmQueueTo(int ms)
+{
+    if (!m_formatCtx || !m_pcmQueue) {
+        return;
+    }
 
-            // 更新音频时钟
-            updateAudioClock(copySize);
+    int targetBytes = m_sampleRate * m_channels * 2 * ms / 1000;
+    while (!m_isEOF && queuedPcmBytes() < targetBytes) {
+        if (!decodeAudioFrame()) {
+            break;
         }
     }
 }
 
+int AudioThread::queuedPcmBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pcmQueue ? av_fifo_size(m_pcmQueue) : 0;
+}
+
 bool AudioThread::decodeAudioFrame()
 {
     if (m_isEOF) {
@@ -513,109 +642,267 @@ bool AudioThread::decodeAudioFrame()
         int ret = av_read_frame(m_formatCtx, m_packet);
         if (ret < 0) {
             if (ret == AVERROR_EOF) {
+                // 冲刷解码器和滤镜里剩余的数据
+                avcodec_send_packet(m_codecCtx, nullptr);
+                int produced = receiveDecodedFrames();
+                produced += drainAudioFilter();
+
+                // 循环到文件末尾：跳回起点，下次补充队列时接着解
+                if (m_loopStartMs >= 0 && (m_loopSkipping || loopBack())) {
+                    return produced > 0;
+                }
                 m_isEOF = true;
                 qDebug() << "音频文件结束";
-
-                // 发送最终位置
-                emit positionChanged(static_cast<qint64>(m_audioClock * 1000));
-
-                // 尝试刷新解码器缓冲区
-                m_packet->data = nullptr;
-                m_packet->size = 0;
-                ret = avcodec_send_packet(m_codecCtx, m_packet);
-                if (ret >= 0) {
-                    continue;  // 继续处理缓冲区的帧
-                }
+                return produced > 0;
             }
             return false;
         }
 
         // 2. 检查是否是音频包
-        if (m_packet->stream_index == m_audioStreamIndex) {
-            // 3. 发送给解码器
-            ret = avcodec_send_packet(m_codecCtx, m_packet);
+        if (m_packet->stream_index != m_audioStreamIndex) {
+            // 不是音频包，释放并继续
             av_packet_unref(m_packet);
+            continue;
+        }
 
-            if (ret < 0) {
-                qDebug() << "发送音频包到解码器失败";
-                continue;
+        // 3. 发送给解码器
+        ret = avcodec_send_packet(m_codecCtx, m_packet);
+        av_packet_unref(m_packet);
+
+        if (ret < 0) {
+            qDebug() << "发送音频包到解码器失败";
+            continue;
+        }
+
+        // 4. 接收解码后的帧（需要更多输入时继续读包）
+        if (receiveDecodedFrames() > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int AudioThread::receiveDecodedFrames()
+{
+    int produced = 0;
+    while (true) {
+        int ret = avcodec_receive_frame(m_codecCtx, m_frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        }
+        if (ret < 0) {
+            // 解码错误
+            qDebug() << "音频解码错误";
+            break;
+        }
+
+        produced += processDecodedFrame(m_frame);
+        av_frame_unref(m_frame);
+    }
+    return produced;
+}
+
+int AudioThread::processDecodedFrame(AVFrame *frame)
+{
+    AVStream *stream = m_formatCtx->streams[m_audioStreamIndex];
+
+    // 5. 更新音频PTS
+    if (frame->pts != AV_NOPTS_VALUE) {
+        m_audioPts = frame->pts * av_q2d(stream->time_base);
+
+        if (m_loopStartMs >= 0) {
+            double frameEnd = m_audioPts + frame->nb_samples / (double)qMax(frame->sample_rate, 1);
+            if (m_loopSkipping && frameEnd <= m_loopStartMs / 1000.0) {
+                // 跳回起点时落在起点之前的帧
+                return 0;
+            }
+            m_loopSkipping = false;
+            if (m_loopEndMs >= 0 && m_audioPts >= m_loopEndMs / 1000.0) {
+                // 到循环终点：这一帧不要，跳回起点
+                loopBack();
+                return 0;
             }
+        }
+    }
 
-            // 4. 接收解码后的帧
-            ret = avcodec_receive_frame(m_codecCtx, m_frame);
-            if (ret >= 0) {
-                // 5. 更新音频PTS（用于精确时钟）
-                if (m_frame->pts != AV_NOPTS_VALUE) {
-                    AVStream *stream = m_formatCtx->streams[m_audioStreamIndex];
-                    m_audioPts = m_frame->pts * av_q2d(stream->time_base);
-                    m_audioClock = m_audioPts;  // 更新时钟
-                }
+    if (m_audioFilterDesc.isEmpty()) {
+        return queueConvertedFrame(frame, stream->time_base);
+    }
 
-                // 6. 重采样
-                int dst_nb_samples = av_rescale_rnd(
-                            swr_get_delay(m_swrCtx, m_sampleRate) + m_frame->nb_samples,
-                            m_sampleRate, m_sampleRate, AV_ROUND_UP);
+    // 按需建立滤镜图（切换滤镜或跳转后重新建立）
+    if (!m_audioFilter.isActive()) {
+        if (!m_audioFilter.init(m_audioFilterDesc, m_sampleRate, m_sampleFmt,
+                                m_audioChannelLayout, stream->time_base)) {
+            qDebug() << "音频滤镜初始化失败，已关闭滤镜：" << m_audioFilterDesc;
+            m_audioFilterDesc.clear();
+            return queueConvertedFrame(frame, stream->time_base);
+        }
+    }
 
+    if (frame->channel_layout == 0) {
+        frame->channel_layout = m_audioChannelLayout;
+    }
 
-                if (!qFuzzyCompare(m_speed, 1.0f)) {
-                    dst_nb_samples = static_cast<int>(dst_nb_samples / m_speed);
-                }
+    if (m_audioFilter.sendFrame(frame) < 0) {
+        qDebug() << "送入音频滤镜失败";
+        return 0;
+    }
+    return receiveFilteredFrames();
+}
 
-                // 分配足够大的缓冲区
-                allocateAudioBuffer(dst_nb_samples);
+int AudioThread::receiveFilteredFrames()
+{
+    int produced = 0;
+    while (m_audioFilter.receiveFrame(m_filterFrame) >= 0) {
+        produced += queueConvertedFrame(m_filterFrame, m_audioFilter.outputTimeBase());
+        av_frame_unref(m_filterFrame);
+    }
+    return produced;
+}
 
-                // 执行重采样
-                ret = swr_convert(m_swrCtx,
-                                  &m_audioBuffer,  // 输出缓冲区
-                                  dst_nb_samples,  // 输出样本数
-                                  (const uint8_t**)m_frame->data,  // 输入数据
-                                  m_frame->nb_samples);            // 输入样本数
+int AudioThread::drainAudioFilter()
+{
+    if (!m_audioFilter.isActive()) {
+        return 0;
+    }
 
-                if (ret > 0) {
-                    // 计算缓冲区大小（样本数 × 声道数 × 每样本字节数）
-                    m_audioBufferLen = ret * m_channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16);
-                    m_audioBufferIndex = 0;
+    m_audioFilter.sendFrame(nullptr);
+    int produced = receiveFilteredFrames();
+    m_audioFilter.release();
+    return produced;
+}
 
-                    // 应用音量
-                    if (m_volume != 1.0f) {
-                        applyVolume(m_audioBuffer, m_audioBufferLen, m_volume);
-                    }
+int AudioThread::queueConvertedFrame(AVFrame *frame, AVRational timeBase)
+{
+    // 6. 重采样
+    int dst_nb_samples = av_rescale_rnd(
+                swr_get_delay(m_swrCtx, m_sampleRate) + frame->nb_samples,
+                m_sampleRate, m_sampleRate, AV_ROUND_UP);
 
-                    av_frame_unref(m_frame);
-                    return true;
-                }
-            } else if (ret == AVERROR(EAGAIN)) {
-                // 需要更多输入数据
-                continue;
-            } else {
-                // 解码错误
-                qDebug() << "音频解码错误" ;
-            }
-        } else {
-            // 不是音频包，释放并继续
-            av_packet_unref(m_packet);
+
+    if (!qFuzzyCompare(m_speed, 1.0f)) {
+        dst_nb_samples = static_cast<int>(dst_nb_samples / m_speed);
+    }
+
+    // 预分配的缓冲区一般够用，比预估的还大时才扩
+    allocateAudioBuffer(dst_nb_samples);
+    if (!m_audioBuffer) {
+        return 0;
+    }
+
+    // 执行重采样
+    int ret = swr_convert(m_swrCtx,
+                          &m_audioBuffer,  // 输出缓冲区
+                          dst_nb_samples,  // 输出样本数
+                          (const uint8_t**)frame->data,  // 输入数据
+                          frame->nb_samples);            // 输入样本数
+
+    if (ret <= 0) {
+        return 0;
+    }
+
+    // 计算缓冲区大小（样本数 × 声道数 × 每样本字节数）
+    m_audioBufferLen = ret * m_channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16);
+
+    // 队列末尾时间 = 本帧起始时间 + 本帧时长（按倍速换算回媒体时间）
+    double startPts = m_queueEndPts;
+    if (frame->pts != AV_NOPTS_VALUE) {
+        startPts = frame->pts * av_q2d(timeBase);
+    }
+    double endPts = startPts + ret / (double)m_sampleRate * m_speed;
+
+    writePcm(m_audioBuffer, m_audioBufferLen, endPts);
+    return m_audioBufferLen;
+}
+
+void AudioThread::writePcm(const uint8_t *data, int len, double endPts)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int space = av_fifo_space(m_pcmQueue);
+    if (space < len) {
+        // av_fifo_grow的参数是相对已有数据（不是剩余空间）还要多出的字节数；
+        // 实际至少翻倍扩容，按扩容前后的总容量记账
+        int capacity = space + av_fifo_size(m_pcmQueue);
+        if (av_fifo_grow(m_pcmQueue, len) < 0) {
+            qDebug() << "PCM队列扩容失败:" << len << "字节";
+            return;
         }
+        MemoryBudget::charge(MemoryBudget::PcmQueue,
+                             av_fifo_space(m_pcmQueue) + av_fifo_size(m_pcmQueue) - capacity);
     }
 
-    return false;
+    av_fifo_generic_write(m_pcmQueue, (void*)data, len, nullptr);
+    m_queueEndPts = endPts;
 }
 
-void AudioThread::updateAudioClock(int bytesPlayed)
+bool AudioThread::loopBack()
 {
-    // 计算播放的时长（秒）
-    double secondsPlayed = bytesPlayed / (double)(m_channels * m_sampleRate * 2);
-    secondsPlayed *= m_speed;
-    // 更新音频时钟
-    m_audioClock += secondsPlayed;
+    AVStream *stream = m_formatCtx->streams[m_audioStreamIndex];
+    int64_t targetPts = av_rescale_q(m_loopStartMs, AVRational{1, 1000}, stream->time_base);
+    if (av_seek_frame(m_formatCtx, m_audioStreamIndex, targetPts, AVSEEK_FLAG_BACKWARD) < 0) {
+        qDebug() << "音频循环跳回失败";
+        return false;
+    }
+    avcodec_flush_buffers(m_codecCtx);
+    m_audioFilter.release();
+    m_audioPts = m_loopStartMs / 1000.0;
+    m_loopSkipping = true;
 
-    // 定期发送位置更新（避免太频繁）
-    static qint64 lastUpdateTime = 0;
-    qint64 currentTime = static_cast<qint64>(m_audioClock * 1000);
+    // 队列里已有的数据照常播完，后面直接接起点的数据
+    QMutexLocker locker(&m_mutex);
+    m_loopTailBytes = av_fifo_size(m_pcmQueue);
+    m_loopTailEndPts = m_queueEndPts;
+    m_queueEndPts = m_audioPts;
+    return true;
+}
 
-    if (currentTime - lastUpdateTime >= 100) {  // 每100ms更新一次
-        emit positionChanged(currentTime);
-        lastUpdateTime = currentTime;
+void AudioThread::trimPcmQueue(double endPts)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int frameBytes = m_channels * 2;
+    int size = av_fifo_size(m_pcmQueue);
+    int extra = static_cast<int>((m_queueEndPts - endPts) / m_speed * m_sampleRate) * frameBytes;
+    if (extra <= 0 || frameBytes <= 0) {
+        return;
     }
+
+    // 队列只能从头读，把要留下的部分读出来再写回去
+    int keep = qMax(0, size - extra);
+    QByteArray kept(keep, 0);
+    av_fifo_generic_read(m_pcmQueue, kept.data(), keep, nullptr);
+    av_fifo_reset(m_pcmQueue);
+    av_fifo_generic_write(m_pcmQueue, kept.data(), keep, nullptr);
+    m_queueEndPts = endPts;
+    m_loopTailBytes = qMin(m_loopTailBytes, keep);
+}
+
+void AudioThread::updateAudioClock(int bytesPlayed)
+{
+    if (bytesPlayed <= 0) {
+        return;
+    }
+
+    // 时钟 = 队列末尾时间 - 队列里还没播放的时长；
+    // 队列里还有循环终点前的数据时按那一段的末尾算，播完才接到起点
+    double bytesPerSecond = m_channels * m_sampleRate * 2;
+    if (m_loopTailBytes > 0) {
+        m_audioClock = m_loopTailEndPts - m_loopTailBytes / bytesPerSecond * m_speed;
+    } else {
+        double queuedSeconds = av_fifo_size(m_pcmQueue) / bytesPerSecond;
+        queuedSeconds *= m_speed;
+        m_audioClock = m_queueEndPts - queuedSeconds;
+    }
+    PlaybackStats::audioClockMs.storeRelease(static_cast<qint64>(m_audioClock * 1000));
+}
+
+int AudioThread::maxConvertedSamples() const
+{
+    // 一帧最多多少样本（不定长的编码器按8192算），加上重采样器里的延迟，0.5倍速时再翻倍
+    int frameSamples = (m_codecCtx && m_codecCtx->frame_size > 0) ? m_codecCtx->frame_size : 8192;
+    return (frameSamples + 256) * 2;
 }
 
 void AudioThread::allocateAudioBuffer(int samples)
@@ -626,7 +913,7 @@ void AudioThread::allocateAudioBuffer(int samples)
         // 释放旧缓冲区
         freeAudioBuffer();
 
-        // 分配新缓冲区
+        // 分配新缓冲区（打开时已按最坏情况分配，播放中一般走不到这里）
         m_audioBuffer = (uint8_t*)av_malloc(requiredSize);
         if (!m_audioBuffer) {
             qDebug() << "无法分配音频缓冲区:" << requiredSize << "字节";
@@ -646,7 +933,6 @@ void AudioThread::freeAudioBuffer()
     }
     m_audioBufferSize = 0;
     m_audioBufferLen = 0;
-    m_audioBufferIndex = 0;
 }
 
 void AudioThread::applyVolume(uint8_t *data, int len, float volume)
@@ -676,9 +962,19 @@ void AudioThread::cleanup()
 
     // 停止播放
     stopPlayback();
+    if (m_producerTimer) {
+        m_producerTimer->stop();
+    }
 
     // 清理音频缓冲区
     freeAudioBuffer();
+    if (m_pcmQueue) {
+        MemoryBudget::charge(MemoryBudget::PcmQueue,
+                             -(av_fifo_space(m_pcmQueue) + av_fifo_size(m_pcmQueue)));
+        av_fifo_freep(&m_pcmQueue);
+    }
+    m_queueEndPts = 0.0;
+    m_audioFilter.release();
 
     // 清理FFmpeg资源
     if (m_swrCtx) {
@@ -696,6 +992,10 @@ void AudioThread::cleanup()
         m_packet = nullptr;
     }
 
+    if (m_filterFrame) {
+        av_frame_free(&m_filterFrame);
+    }
+
     if (m_codecCtx) {
         avcodec_free_context(&m_codecCtx);
         m_codecCtx = nullptr;
@@ -712,9 +1012,10 @@ void AudioThread::cleanup()
     m_channels = 0;
     m_audioClock = 0.0;
     m_audioPts = 0.0;
-    m_startTime = 0;
     m_isPlaying = false;
     m_isEOF = false;
+    m_loopSkipping = false;
+    m_loopTailBytes = 0;
     m_volume = 1.0f;
     m_speed = 1.0f;
 
@@ -4,15 +4,28 @@
 #include <QObject>
 #include <QMutex>
 #include <QElapsedTimer>
-#include "global_status.h"
+#include <QTimer>
+#include "audiofilter.h"
+#include "loudnessscanner.h"
+#include "playerconfig.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libswresample/swresample.h>
+#include <libavutil/fifo.h>
 #include <SDL.h>
 }
 
+// 音频输出旁路：每次回调交给声卡的PCM（S16交错）同时交给它，用于离屏测量
+// 在SDL音频线程里调用，必须很快返回
+class AudioTap
+{
+public:
+    virtual ~AudioTap() {}
+    virtual void played(const uint8_t *pcm, int len, int sampleRate, int channels) = 0;
+};
+
 class AudioThread : public QObject
 {
     Q_OBJECT
@@ -24,17 +37,27 @@ public:
     // 获取精确的音频时钟（秒）
     double getCurrentTime() const;
 
+    // 设置输出旁路（nullptr取消），调用方保证它比播放活得久
+    void setOutputTap(AudioTap *tap);
+
 public slots:
     void init_audio(const QString &filename);
     void setVolume(float volume);
     void setSpeed(float speed);
     void seekTo(qint64 positionMs);
-    void UpadatStatus();
+    void startPlayback();
+    void pausePlayback();
+    void setAudioFilters(QString filters);  // 运行中切换音频滤镜（预设名或滤镜链，空字符串关闭）
+    void setLoop(qint64 startMs, qint64 endMs);  // 循环区间（startMs<0关闭，endMs<0到文件末尾）
+    void onLoudnessReady(QString filePath); // 后台响度扫描完成
+
+private slots:
+    void fillPcmQueue();                     // 生产者：在音频线程解码，保持PCM队列水位
 
 signals:
-    void positionChanged(qint64 positionMs);  // 当前播放位置（毫秒）
     void playbackFinished();                  // 播放完成
     void errorOccurred(const QString &error); // 错误信息
+    void prerolled();                         // 打开/跳转后队列已填到预读水位（失败时也发，免得对方一直等）
 
 private:
     // SDL音频回调
@@ -45,18 +68,29 @@ private:
     bool initAudioDecoder(const QString &filename);
     bool initSDLOutput();
     bool decodeAudioFrame();
+    int receiveDecodedFrames();
+    int processDecodedFrame(AVFrame *frame);
+    int receiveFilteredFrames();
+    int drainAudioFilter();
+    int queueConvertedFrame(AVFrame *frame, AVRational timeBase);
+    void writePcm(const uint8_t *data, int len, double endPts);
+    bool loopBack();                         // 解码到循环终点，demuxer跳回起点接着解
+    void trimPcmQueue(double endPts);        // 丢掉队列里endPts之后的数据
+    int queuedPcmBytes() const;
+    void fillPcmQueueTo(int ms);
+    void seekAndRefill(qint64 positionMs);   // 跳转并把队列填到预读水位（seekTo去掉通知的部分）
     void fillAudioBuffer(Uint8 *stream, int len);
     void updateAudioClock(int bytesPlayed);
     void cleanup();
 
     // 工具函数
+    int maxConvertedSamples() const;
     void allocateAudioBuffer(int samples);
     void freeAudioBuffer();
     void applyVolume(uint8_t *data, int len, float volume);
+    void updateReplayGain();
 
 
-    void startPlayback();
-    void pausePlayback();
     void stopPlayback();
 
 
@@ -79,23 +113,42 @@ private:
     SDL_AudioSpec m_wantedSpec;
     SDL_AudioSpec m_obtainedSpec;
     SDL_AudioDeviceID m_audioDevice = 0;
+    AudioTap *m_outputTap = nullptr;       // 离屏测量时查看输出数据
 
-    // 音频缓冲区（修复：使用单个交错缓冲区）
-    uint8_t *m_audioBuffer = nullptr;      // 交错格式缓冲区
+    // 音频缓冲区（打开时按最坏情况预分配，只增不减，播放中一般不再分配）
+    uint8_t *m_audioBuffer = nullptr;      // 重采样输出的交错格式缓冲区
     int m_audioBufferSize = 0;             // 缓冲区总大小（字节）
     int m_audioBufferLen = 0;              // 当前有效数据长度（字节）
-    int m_audioBufferIndex = 0;            // 当前读取位置
+
+    // PCM队列：音频线程写入，SDL回调只读取（m_mutex保护）
+    AVFifoBuffer *m_pcmQueue = nullptr;
+    double m_queueEndPts = 0.0;            // 队列末尾数据对应的时间（秒）
+    QTimer *m_producerTimer = nullptr;     // 定时补充队列
+
+    // 循环：生产者先跑到终点跳回起点，队列里前后两段首尾相接，声卡那边没有间断
+    qint64 m_loopStartMs = -1;             // 循环起点，-1表示不循环
+    qint64 m_loopEndMs = -1;               // 循环终点，-1表示文件末尾
+    bool m_loopSkipping = false;           // 刚跳回起点，丢掉起点之前的帧
+    int m_loopTailBytes = 0;               // 队列里还没播完的终点前数据（m_mutex保护）
+    double m_loopTailEndPts = 0.0;         // 这段数据末尾的时间
+
+    // 音频滤镜（只在音频线程上使用）
+    AudioFilterGraph m_audioFilter;
+    QString m_audioFilterDesc;
+    AVFrame *m_filterFrame = nullptr;      // 滤镜输出帧
 
     // 音频时钟（精确计算）
     double m_audioClock = 0.0;             // 音频时钟（秒）
     double m_audioPts = 0.0;               // 当前音频帧的PTS（秒）
-    qint64 m_startTime = 0;                // 开始播放的系统时间（毫秒）
 
     // 播放控制
     bool m_isPlaying = false;
     bool m_isEOF = false;                  // 是否到达文件末尾
     float m_volume = 1.0f;
+    float m_replayGain = 1.0f;             // 按响度缓存算出的增益
+    QString m_currentFile;                 // 当前播放的文件
     float m_speed = 1.0f;
+    bool m_fastForwardMuted = false;       // 快进（2倍以上）时静音
 
     // 同步保护
     mutable QMutex m_mutex;
@@ -0,0 +1,792 @@
+#include "benchmark.h"
+#include "playerconfig.h"
+#include "playerengine.h"
+#include "slicescaler.h"
+#include "yuvconverter.h"
+#include "testclip.h"
+#include "videothread.h"
+#include "offscreenrenderbackend.h"
+#include "syncmeter.h"
+#include <QDebug>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QEventLoop>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+int Benchmark::run(const QString &name)
+{
+    qDebug() << "基准测试:" << name << "迭代" << PlayerConfig::benchIterations << "次";
+
+    if (name == "scale") {
+        return scaleBenchmark();
+    }
+    if (name == "yuv") {
+        return yuvBenchmark();
+    }
+    if (name == "yuv-check") {
+        return yuvCheck();
+    }
+    if (name == "golden") {
+        return goldenFrames();
+    }
+    if (name == "avsync") {
+        return avSync();
+    }
+    if (name == "seek") {
+        return seekLatency();
+    }
+
+    qDebug() << "未知的基准测试:" << name << "（可选：scale、yuv、yuv-check、golden、avsync、seek）";
+    return 1;
+}
+
+// 分配一帧带渐变的测试图（YUV420P或NV12），色度覆盖整个取值范围
+static AVFrame *allocTestFrame(int width, int height, AVPixelFormat format)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame) {
+        return nullptr;
+    }
+    frame->width = width;
+    frame->height = height;
+    frame->format = format;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    for (int y = 0; y < height; y++) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < width; x++) {
+            row[x] = (uint8_t)((x + y) & 0xff);
+        }
+    }
+    int chromaWidth = (width + 1) / 2;
+    for (int y = 0; y < (height + 1) / 2; y++) {
+        for (int x = 0; x < chromaWidth; x++) {
+            uint8_t u = (uint8_t)(x & 0xff);
+            uint8_t v = (uint8_t)(y & 0xff);
+            if (format == AV_PIX_FMT_NV12) {
+                uint8_t *uv = frame->data[1] + y * frame->linesize[1];
+                uv[2 * x] = u;
+                uv[2 * x + 1] = v;
+            } else {
+                frame->data[1][y * frame->linesize[1] + x] = u;
+                frame->data[2][y * frame->linesize[2] + x] = v;
+            }
+        }
+    }
+    return frame;
+}
+
+int Benchmark::scaleBenchmark()
+{
+    struct Size { int width; int height; const char *name; };
+    const Size sizes[] = {
+        { 3840, 2160, "4K" },
+        { 7680, 4320, "8K" },
+    };
+
+    // 条数：1,2,4,...直到核心数
+    QVector<int> bandCounts;
+    int cores = QThread::idealThreadCount();
+    for (int bands = 1; bands < cores; bands *= 2) {
+        bandCounts.append(bands);
+    }
+    bandCounts.append(cores);
+
+    for (const Size &size : sizes) {
+        AVFrame *src = allocTestFrame(size.width, size.height, AV_PIX_FMT_YUV420P);
+        uint8_t *dst[4] = { nullptr };
+        int dstLinesize[4] = { 0 };
+        if (!src || av_image_alloc(dst, dstLinesize, size.width, size.height, AV_PIX_FMT_RGB24, 32) < 0) {
+            qDebug() << "内存不足，跳过" << size.name;
+            av_frame_free(&src);
+            continue;
+        }
+
+        qDebug().noquote() << QString("%1 %2x%3 YUV420P -> RGB24，%4核")
+                              .arg(size.name).arg(size.width).arg(size.height).arg(cores);
+        qDebug().noquote() << "  条数    ms/帧     fps   加速比";
+
+        double baseline = 0;
+        for (int bands : bandCounts) {
+            SliceScaler scaler;
+            if (!scaler.init(size.width, size.height, AV_PIX_FMT_YUV420P,
+                             size.width, size.height, AV_PIX_FMT_RGB24, SWS_BILINEAR, bands)) {
+                qDebug() << "转换器创建失败";
+                continue;
+            }
+
+            // 预热一次，让线程池把线程建好
+            scaler.scale(src->data, src->linesize, dst, dstLinesize);
+
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < PlayerConfig::benchIterations; i++) {
+                scaler.scale(src->data, src->linesize, dst, dstLinesize);
+            }
+            double ms = timer.nsecsElapsed() / 1e6 / PlayerConfig::benchIterations;
+            if (baseline <= 0) {
+                baseline = ms;
+            }
+
+            qDebug().noquote() << QString("  %1 %2 %3 %4x")
+                                  .arg(scaler.bandCount(), 4)
+                                  .arg(ms, 8, 'f', 2)
+                                  .arg(1000.0 / ms, 7, 'f', 1)
+                                  .arg(baseline / ms, 6, 'f', 2);
+        }
+
+        av_frame_free(&src);
+        av_freep(&dst[0]);
+    }
+    return 0;
+}
+
+// 与手写转换同一矩阵/范围的swscale参照（不缩放，色度取最近样本）
+static SwsContext *createReferenceScaler(int width, int height, AVPixelFormat srcFormat,
+                                         AVPixelFormat dstFormat, AVColorSpace colorspace,
+                                         bool fullRange, int flags)
+{
+    SwsContext *ctx = sws_getContext(width, height, srcFormat, width, height, dstFormat,
+                                     flags, nullptr, nullptr, nullptr);
+    if (!ctx) {
+        return nullptr;
+    }
+    const int *table = sws_getCoefficients(colorspace == AVCOL_SPC_BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+    sws_setColorspaceDetails(ctx, table, fullRange ? 1 : 0, table, 1, 0, 1 << 16, 1 << 16);
+    return ctx;
+}
+
+static const char *formatName(AVPixelFormat format)
+{
+    return av_get_pix_fmt_name(format);
+}
+
+int Benchmark::yuvBenchmark()
+{
+    struct Size { int width; int height; const char *name; };
+    const Size sizes[] = {
+        { 1920, 1080, "1080p" },
+        { 3840, 2160, "4K" },
+    };
+    const AVPixelFormat srcFormats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12 };
+    const AVPixelFormat dstFormats[] = { AV_PIX_FMT_RGB24, AV_PIX_FMT_BGRA };
+    bool avx2 = YuvConverter::hasAvx2();
+    int iterations = PlayerConfig::benchIterations;
+
+    qDebug() << "CPU支持AVX2:" << avx2;
+    for (const Size &size : sizes) {
+        qDebug().noquote() << QString("%1 %2x%3（ms/帧）").arg(size.name).arg(size.width).arg(size.height);
+        qDebug().noquote() << "  转换                  swscale     标量     AVX2   AVX2加速比";
+
+        for (AVPixelFormat srcFormat : srcFormats) {
+            AVFrame *src = allocTestFrame(size.width, size.height, srcFormat);
+            if (!src) {
+                qDebug() << "内存不足，跳过" << size.name;
+                continue;
+            }
+            for (AVPixelFormat dstFormat : dstFormats) {
+                uint8_t *dst[4] = { nullptr };
+                int dstLinesize[4] = { 0 };
+                if (av_image_alloc(dst, dstLinesize, size.width, size.height, dstFormat, 32) < 0) {
+                    continue;
+                }
+
+                // 播放器原来的路径：默认系数的swscale
+                double swsMs = 0;
+                SwsContext *sws = sws_getContext(size.width, size.height, srcFormat,
+                                                 size.width, size.height, dstFormat,
+                                                 SWS_BILINEAR, nullptr, nullptr, nullptr);
+                if (sws) {
+                    sws_scale(sws, src->data, src->linesize, 0, size.height, dst, dstLinesize);
+                    QElapsedTimer timer;
+                    timer.start();
+                    for (int i = 0; i < iterations; i++) {
+                        sws_scale(sws, src->data, src->linesize, 0, size.height, dst, dstLinesize);
+                    }
+                    swsMs = timer.nsecsElapsed() / 1e6 / iterations;
+                    sws_freeContext(sws);
+                }
+
+                double kernelMs[2] = { 0, 0 };
+                for (int k = 0; k < 2; k++) {
+                    YuvConverter::Kernel kernel = (k == 0) ? YuvConverter::KernelScalar : YuvConverter::KernelAvx2;
+                    if (kernel == YuvConverter::KernelAvx2 && !avx2) {
+                        continue;
+                    }
+                    YuvConverter converter;
+                    converter.init(size.width, size.height, srcFormat, dstFormat,
+                                   AVCOL_SPC_BT709, AVCOL_RANGE_MPEG, kernel);
+                    converter.convert(src, dst[0], dstLinesize[0]);
+                    QElapsedTimer timer;
+                    timer.start();
+                    for (int i = 0; i < iterations; i++) {
+                        converter.convert(src, dst[0], dstLinesize[0]);
+                    }
+                    kernelMs[k] = timer.nsecsElapsed() / 1e6 / iterations;
+                }
+
+                QString label = QString("%1 -> %2").arg(formatName(srcFormat)).arg(formatName(dstFormat));
+                qDebug().noquote() << QString("  %1 %2 %3 %4 %5")
+                                      .arg(label, -20)
+                                      .arg(swsMs, 8, 'f', 2)
+                                      .arg(kernelMs[0], 8, 'f', 2)
+                                      .arg(avx2 ? QString::number(kernelMs[1], 'f', 2) : QString("-"), 8)
+                                      .arg(avx2 && kernelMs[1] > 0
+                                           ? QString::number(swsMs / kernelMs[1], 'f', 2) + "x" : QString("-"), 10);
+                av_freep(&dst[0]);
+            }
+            av_frame_free(&src);
+        }
+    }
+    return 0;
+}
+
+int Benchmark::yuvCheck()
+{
+    // 奇数尺寸，覆盖向量循环后的标量收尾和奇数色度
+    const int width = 1281;
+    const int height = 721;
+    // swscale的定点精度和我们不同，不要求逐字节一致
+    const double minPsnr = 38.0;
+
+    const AVPixelFormat srcFormats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12 };
+    const AVPixelFormat dstFormats[] = { AV_PIX_FMT_RGB24, AV_PIX_FMT_BGRA, AV_PIX_FMT_RGBA };
+    const AVColorSpace colorspaces[] = { AVCOL_SPC_SMPTE170M, AVCOL_SPC_BT709 };
+    bool avx2 = YuvConverter::hasAvx2();
+    int failures = 0;
+
+    if (!avx2) {
+        qDebug() << "CPU不支持AVX2，只检查标量实现";
+    }
+
+    for (AVPixelFormat srcFormat : srcFormats) {
+        AVFrame *src = allocTestFrame(width, height, srcFormat);
+        if (!src) {
+            return 1;
+        }
+        for (AVPixelFormat dstFormat : dstFormats) {
+            int pixelBytes = (dstFormat == AV_PIX_FMT_RGB24) ? 3 : 4;
+            int linesize = width * pixelBytes;
+            QVector<uint8_t> scalarOut(linesize * height);
+            QVector<uint8_t> avx2Out(linesize * height);
+            QVector<uint8_t> swsOut(linesize * height);
+
+            for (AVColorSpace colorspace : colorspaces) {
+                for (int full = 0; full < 2; full++) {
+                    AVColorRange range = full ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+
+                    YuvConverter scalar;
+                    scalar.init(width, height, srcFormat, dstFormat, colorspace, range, YuvConverter::KernelScalar);
+                    scalar.convert(src, scalarOut.data(), linesize);
+
+                    // AVX2必须和标量逐字节相同
+                    int mismatches = 0;
+                    if (avx2) {
+                        YuvConverter vector;
+                        vector.init(width, height, srcFormat, dstFormat, colorspace, range, YuvConverter::KernelAvx2);
+                        vector.convert(src, avx2Out.data(), linesize);
+                        for (int i = 0; i < scalarOut.size(); i++) {
+                            if (scalarOut[i] != avx2Out[i]) {
+                                mismatches++;
+                            }
+                        }
+                    }
+
+                    // 和swscale比较RGB三个分量的PSNR
+                    double psnr = 0;
+                    SwsContext *sws = createReferenceScaler(width, height, srcFormat, dstFormat, colorspace,
+                                                            full != 0, SWS_POINT | SWS_ACCURATE_RND);
+                    if (sws) {
+                        uint8_t *dst[4] = { swsOut.data(), nullptr, nullptr, nullptr };
+                        int dstLinesize[4] = { linesize, 0, 0, 0 };
+                        sws_scale(sws, src->data, src->linesize, 0, height, dst, dstLinesize);
+                        sws_freeContext(sws);
+
+                        double sum = 0;
+                        qint64 count = 0;
+                        for (int i = 0; i < swsOut.size(); i++) {
+                            if (pixelBytes == 4 && i % 4 == 3) {
+                                continue;
+                            }
+                            int diff = scalarOut[i] - swsOut[i];
+                            sum += diff * diff;
+                            count++;
+                        }
+                        double mse = sum / count;
+                        psnr = (mse > 0) ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+                    }
+
+                    bool ok = (mismatches == 0 && psnr >= minPsnr);
+                    if (!ok) {
+                        failures++;
+                    }
+                    qDebug().noquote() << QString("  %1 -> %2 %3 %4  AVX2差异%5字节  PSNR %6dB  %7")
+                                          .arg(formatName(srcFormat))
+                                          .arg(formatName(dstFormat), -6)
+                                          .arg(colorspace == AVCOL_SPC_BT709 ? "BT.709" : "BT.601")
+                                          .arg(full ? "full   " : "limited")
+                                          .arg(mismatches)
+                                          .arg(psnr, 0, 'f', 1)
+                                          .arg(ok ? "通过" : "失败");
+                }
+            }
+        }
+        av_frame_free(&src);
+    }
+
+    qDebug() << (failures == 0 ? "全部通过" : "存在失败项:") << failures;
+    return failures == 0 ? 0 : 1;
+}
+
+// 一个片段的播放和跳转记录，每行"片段 play 序号 pts CRC"或"片段 seek 目标ms pts CRC"
+static QStringList recordClip(const QString &name, const QString &path, const TestClip::Params &params)
+{
+    QStringList records;
+    VideoThread video;
+    video.init_video(path);
+    video.startPlayback();
+    OffscreenRenderBackend *sink = dynamic_cast<OffscreenRenderBackend*>(video.renderer());
+    if (!sink) {
+        qDebug() << "离屏输出未打开：" << path;
+        return records;
+    }
+
+    auto lastCrc = [sink]() {
+        return QString("%1").arg(sink->lastCrc(), 8, 16, QChar('0'));
+    };
+
+    // 1. 从头播放到结束：不经过事件循环，直接驱动定时器回调（第一帧在预读时已显示）
+    int shown = 0;
+    auto recordShown = [&]() {
+        if (sink->frameCount() > shown) {
+            shown = sink->frameCount();
+            records << QString("%1 play %2 %3 %4").arg(name).arg(shown - 1).arg(video.currentPts()).arg(lastCrc());
+        }
+    };
+    recordShown();
+    int maxTicks = params.frames * 10;
+    for (int tick = 0; tick < maxTicks && PlayerEngine::state() == STATE_PLAYING; tick++) {
+        video.onPlayTimerTimeout();
+        recordShown();
+    }
+
+    // 2. 精确跳转：开头、GOP中间、向后跳、两帧之间、最后一帧
+    int duration = TestClip::durationMs(params);
+    int frameMs = qMax(1, duration / params.frames);
+    const int targets[] = {
+        0,
+        duration * 37 / 100,
+        duration * 80 / 100,
+        duration * 20 / 100,
+        duration / 2 + frameMs / 2,
+        duration - frameMs,
+    };
+    for (int target : targets) {
+        int before = sink->frameCount();
+        video.decodeUntilTarget(target, true);
+        bool presented = sink->frameCount() > before;
+        records << QString("%1 seek %2 %3 %4").arg(name).arg(target)
+                   .arg(presented ? video.currentPts() : AV_NOPTS_VALUE)
+                   .arg(presented ? lastCrc() : QString("none"));
+    }
+    return records;
+}
+
+// 期望文件默认跟源码一起提交；不在源码树里运行时再找程序目录
+static QString goldenFilePath()
+{
+    if (!PlayerConfig::goldenFile.isEmpty()) {
+        return PlayerConfig::goldenFile;
+    }
+    QStringList dirs;
+#ifdef VIDIO_SOURCE_DIR
+    dirs << QString::fromUtf8(VIDIO_SOURCE_DIR);
+#endif
+    dirs << QCoreApplication::applicationDirPath();
+    for (const QString &dir : dirs) {
+        QString path = QDir(dir).filePath("golden_frames.txt");
+        if (QFile::exists(path)) {
+            return path;
+        }
+    }
+    return QDir(dirs.first()).filePath("golden_frames.txt");
+}
+
+int Benchmark::goldenFrames()
+{
+    struct Clip { const char *name; TestClip::Params params; };
+    Clip clips[4];
+    clips[0].name = "gop12_b2";                 // 默认：GOP 12，2个B帧，25fps
+    clips[1].name = "intra";                    // 全关键帧，跳转不需要从前面解起
+    clips[1].params.gopSize = 1;
+    clips[1].params.maxBFrames = 0;
+    clips[2].name = "gop30_ntsc";               // 29.97fps，毫秒到pts的换算有舍入
+    clips[2].params.frameRate = { 30000, 1001 };
+    clips[2].params.gopSize = 30;
+    clips[2].params.frames = 90;
+    clips[3].name = "odd_720p";                 // 非16倍数的尺寸，覆盖转换的收尾
+    clips[3].params.width = 1282;
+    clips[3].params.height = 722;
+    clips[3].params.frames = 30;
+
+    QDir dir(QDir::temp().filePath("vidio_golden"));
+    if (!dir.mkpath(".")) {
+        qDebug() << "无法创建临时目录" << dir.path();
+        return 1;
+    }
+
+    // 不需要窗口，每帧只算CRC
+    PlayerConfig::renderBackend = "offscreen";
+
+    QStringList actual;
+    for (const Clip &clip : clips) {
+        QString path = dir.filePath(QString("%1.mp4").arg(clip.name));
+        if (!TestClip::write(path, clip.params)) {
+            return 1;
+        }
+        QStringList records = recordClip(clip.name, path, clip.params);
+        if (records.isEmpty()) {
+            return 1;
+        }
+        qDebug().noquote() << QString("  %1：%2条记录").arg(clip.name).arg(records.size());
+        actual << records;
+    }
+
+    // 期望只对同一版本的FFmpeg有效（编解码器的输出可能随版本变化）
+    QString version = QString("# ffmpeg %1").arg(av_version_info());
+    QFile file(goldenFilePath());
+    if (PlayerConfig::goldenUpdate) {
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qDebug() << "无法写入期望文件" << file.fileName();
+            return 1;
+        }
+        QTextStream out(&file);
+        out << "# 黄金帧期望：片段 play 序号 pts CRC32 / 片段 seek 目标ms pts CRC32\n";
+        out << version << "\n";
+        for (const QString &line : actual) {
+            out << line << "\n";
+        }
+        qDebug() << "已生成期望文件" << file.fileName() << actual.size() << "条，检查后提交";
+        return 0;
+    }
+
+    // 缺了期望文件算失败，不能悄悄生成一份再报通过
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "无法读取期望文件" << file.fileName() << "（用 --golden-update 生成）";
+        return 1;
+    }
+    QStringList expected;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.startsWith("# ffmpeg") && line != version) {
+            qDebug().noquote() << "警告：期望文件生成于" << line.mid(2) << "，当前为" << version.mid(2);
+        }
+        if (!line.isEmpty() && !line.startsWith('#')) {
+            expected << line;
+        }
+    }
+
+    if (expected.isEmpty()) {
+        qDebug() << "期望文件里没有记录" << file.fileName()
+                 << "（用随附的FFmpeg构建运行 --bench golden --golden-update 生成，检查后提交）";
+        return 1;
+    }
+
+    int failures = 0;
+    int count = qMax(expected.size(), actual.size());
+    for (int i = 0; i < count; i++) {
+        QString want = (i < expected.size()) ? expected.at(i) : QString("（无）");
+        QString got = (i < actual.size()) ? actual.at(i) : QString("（无）");
+        if (want == got) {
+            continue;
+        }
+        if (failures < 20) {
+            qDebug().noquote() << "  期望:" << want;
+            qDebug().noquote() << "  实际:" << got;
+        }
+        failures++;
+    }
+
+    qDebug() << (failures == 0 ? "全部通过" : "存在失败项:") << failures << "/" << count;
+    return failures == 0 ? 0 : 1;
+}
+
+// 像主窗口一样把视频、音频各放一个线程，实时播放到离屏输出，返回同步偏差
+static SyncMeter::Result playForSync(const QString &path, float speed, int durationMs, int periodMs)
+{
+    SyncMeter meter;
+    VideoThread *video = new VideoThread;
+    AudioThread *audio = new AudioThread;
+    QThread videoThread;
+    QThread audioThread;
+    video->moveToThread(&videoThread);
+    audio->moveToThread(&audioThread);
+    QObject::connect(&videoThread, &QThread::finished, video, &QObject::deleteLater);
+    QObject::connect(&audioThread, &QThread::finished, audio, &QObject::deleteLater);
+    video->setAudioReference(audio);
+    audio->setOutputTap(&meter);
+    // 打开和开始走主窗口同样的路径（两边预读好后一起开始）
+    PlayerEngine *engine = new PlayerEngine(video, audio);
+    engine->moveToThread(&videoThread);
+    QObject::connect(&videoThread, &QThread::finished, engine, &QObject::deleteLater);
+    videoThread.start();
+    audioThread.start();
+
+    // 开始播放时取离屏输出，播放结束（或超时）退出
+    QEventLoop loop;
+    OffscreenRenderBackend *sink = nullptr;
+    QObject::connect(video, &VideoThread::UpadatButton, &loop, [&](bool playing) {
+        if (playing) {
+            sink = dynamic_cast<OffscreenRenderBackend*>(video->renderer());
+        } else {
+            loop.quit();
+        }
+    });
+    QTimer::singleShot(static_cast<int>(durationMs / speed) + 5000, &loop, &QEventLoop::quit);
+
+    engine->open(path);
+    engine->setSpeed(speed);
+    loop.exec();
+
+    QVector<OffscreenRenderBackend::Frame> frames;
+    if (sink) {
+        frames = sink->frames();
+    }
+    audio->setOutputTap(nullptr);
+    videoThread.quit();
+    audioThread.quit();
+    videoThread.wait();
+    audioThread.wait();
+
+    // 媒体上间隔periodMs，按倍速换成实际时间，偏差超过半个间隔算没配上
+    qint64 maxGapUs = static_cast<qint64>(periodMs * 1000 / speed / 2);
+    return SyncMeter::measure(SyncMeter::flashTimes(frames), meter.beepTimes(), maxGapUs);
+}
+
+int Benchmark::avSync()
+{
+    const int seconds = 10;
+    const int periodMs = 500;
+    struct Clip { const char *name; const char *ext; AVRational frameRate; AVCodecID video; AVCodecID audio; };
+    const Clip clips[] = {
+        { "mpeg4+aac 25fps",     "mp4", { 25, 1 },       AV_CODEC_ID_MPEG4, AV_CODEC_ID_AAC },
+        { "mpeg4+aac 29.97fps",  "mp4", { 30000, 1001 }, AV_CODEC_ID_MPEG4, AV_CODEC_ID_AAC },
+        { "mpeg4+mp2 23.976fps", "mkv", { 24000, 1001 }, AV_CODEC_ID_MPEG4, AV_CODEC_ID_MP2 },
+        { "mjpeg+pcm 50fps",     "mkv", { 50, 1 },       AV_CODEC_ID_MJPEG, AV_CODEC_ID_PCM_S16LE },
+    };
+    const float speeds[] = { 0.5f, 1.0f, 1.5f, 2.0f };
+
+    QDir dir(QDir::temp().filePath("vidio_avsync"));
+    if (!dir.mkpath(".")) {
+        qDebug() << "无法创建临时目录" << dir.path();
+        return 1;
+    }
+
+    // 不开窗口也不出声，两路输出都按实时节奏进行
+    PlayerConfig::renderBackend = "offscreen";
+    PlayerConfig::audioOutput = "offscreen";
+
+    for (int i = 0; i < int(sizeof(clips) / sizeof(clips[0])); i++) {
+        const Clip &clip = clips[i];
+        TestClip::Params params;
+        params.frameRate = clip.frameRate;
+        params.frames = static_cast<int>(std::ceil(seconds * av_q2d(clip.frameRate)));
+        params.videoCodec = clip.video;
+        params.audioCodec = clip.audio;
+        params.flashPeriodMs = periodMs;
+        if (clip.video == AV_CODEC_ID_MJPEG) {
+            params.gopSize = 1;
+            params.maxBFrames = 0;
+        }
+
+        QString path = dir.filePath(QString("clip%1.%2").arg(i).arg(clip.ext));
+        if (!TestClip::write(path, params)) {
+            return 1;
+        }
+
+        qDebug().noquote() << QString("%1（每%2ms闪白/响一声，偏差=画面-声音）").arg(clip.name).arg(periodMs);
+        qDebug().noquote() << "  倍速  配对  漏配   平均ms    p95ms    最大ms  漂移ms/分";
+        for (float speed : speeds) {
+            SyncMeter::Result result = playForSync(path, speed, TestClip::durationMs(params), periodMs);
+            qDebug().noquote() << QString("  %1x %2 %3 %4 %5 %6 %7")
+                                  .arg(speed, 3, 'f', 1)
+                                  .arg(result.events, 5)
+                                  .arg(result.missed, 5)
+                                  .arg(result.meanMs, 8, 'f', 1)
+                                  .arg(result.p95Ms, 8, 'f', 1)
+                                  .arg(result.maxMs, 8, 'f', 1)
+                                  .arg(result.driftMsPerMin, 10, 'f', 1);
+        }
+    }
+    return 0;
+}
+
+// 已排序数组的分位数（最近秩）
+static double percentile(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    int rank = static_cast<int>(std::ceil(sorted.size() * p)) - 1;
+    return sorted.at(qBound(0, rank, sorted.size() - 1));
+}
+
+// 跳转测试的片段：指定的目录/文件，没有指定时生成合成片段
+static QStringList seekCorpus()
+{
+    QStringList files;
+    if (!PlayerConfig::benchCorpus.isEmpty()) {
+        QFileInfo info(PlayerConfig::benchCorpus);
+        if (info.isDir()) {
+            QDir dir(info.filePath());
+            QStringList filters;
+            filters << "*.mp4" << "*.mkv" << "*.mov" << "*.avi" << "*.ts" << "*.webm" << "*.flv";
+            for (const QString &name : dir.entryList(filters, QDir::Files, QDir::Name)) {
+                files << dir.filePath(name);
+            }
+        } else {
+            files << info.filePath();
+        }
+        return files;
+    }
+
+    QDir dir(QDir::temp().filePath("vidio_seek"));
+    if (!dir.mkpath(".")) {
+        return files;
+    }
+    // 短GOP小画面，和长GOP的720p（一次跳转最多要解250帧）
+    TestClip::Params shortGop;
+    shortGop.frames = 500;
+    TestClip::Params longGop;
+    longGop.width = 1280;
+    longGop.height = 720;
+    longGop.frames = 500;
+    longGop.gopSize = 250;
+    QString shortPath = dir.filePath("gop12_320x240.mp4");
+    QString longPath = dir.filePath("gop250_1280x720.mp4");
+    if (TestClip::write(shortPath, shortGop) && TestClip::write(longPath, longGop)) {
+        files << shortPath << longPath;
+    }
+    return files;
+}
+
+int Benchmark::seekLatency()
+{
+    QStringList files = seekCorpus();
+    if (files.isEmpty()) {
+        qDebug() << "没有可测试的文件";
+        return 1;
+    }
+
+    // 不需要窗口，转换和输出照常进行
+    PlayerConfig::renderBackend = "offscreen";
+
+    for (const QString &path : files) {
+        // 先单独打开一次拿时长和帧率
+        AVFormatContext *probe = nullptr;
+        if (avformat_open_input(&probe, path.toUtf8().constData(), nullptr, nullptr) < 0 ||
+                avformat_find_stream_info(probe, nullptr) < 0) {
+            qDebug() << "无法打开" << path;
+            avformat_close_input(&probe);
+            continue;
+        }
+        int durationMs = static_cast<int>(probe->duration / 1000);
+        int streamIndex = av_find_best_stream(probe, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        double fps = (streamIndex >= 0) ? av_q2d(probe->streams[streamIndex]->avg_frame_rate) : 0;
+        avformat_close_input(&probe);
+        if (durationMs <= 0 || streamIndex < 0) {
+            qDebug() << "跳过（没有时长或视频流）" << path;
+            continue;
+        }
+        int frameMs = static_cast<int>(1000 / (fps > 0 ? fps : 25));
+
+        VideoThread video;
+        video.init_video(path);
+        if (!video.renderer()) {
+            continue;
+        }
+
+        // fromMs<0表示不先定位；stepTo为真时先跳到目标附近再逐帧走到fromMs（包进回看缓冲）
+        struct Seek { int fromMs; int targetMs; bool stepTo; };
+        struct Kind { const char *name; QVector<Seek> seeks; };
+        Kind kinds[5] = { { "随机", {} }, { "顺序前进", {} }, { "短距后退", {} }, { "缓冲内后退", {} }, { "跳到结尾", {} } };
+
+        // 固定种子，每次运行的目标都一样
+        std::mt19937 generator(20240501);
+        for (int i = 0; i < PlayerConfig::benchIterations; i++) {
+            kinds[0].seeks.append({ -1, static_cast<int>(generator() % (unsigned)durationMs), false });
+        }
+        for (int i = 1; i <= 20; i++) {
+            kinds[1].seeks.append({ -1, durationMs * i / 21, false });
+        }
+        for (int i = 1; i <= 10; i++) {
+            int from = durationMs * i / 11;
+            kinds[2].seeks.append({ from, qMax(0, from - 2000), false });
+            kinds[3].seeks.append({ from, qMax(0, from - 2000), true });
+        }
+        for (int i = 0; i < 5; i++) {
+            kinds[4].seeks.append({ durationMs / 2, qMax(0, durationMs - frameMs), false });
+        }
+
+        qDebug().noquote() << QString("%1（%2秒，%3fps）").arg(QFileInfo(path).fileName())
+                              .arg(durationMs / 1000.0, 0, 'f', 1).arg(fps, 0, 'f', 2);
+        qDebug().noquote() << "  类型        次数   p50ms   p90ms   p99ms   最大ms  解码帧/次  不准";
+
+        for (const Kind &kind : kinds) {
+            QVector<double> latencies;
+            qint64 decoded = 0;
+            int wrong = 0;
+            for (const Seek &seek : kind.seeks) {
+                if (seek.stepTo) {
+                    video.decodeUntilTarget(qMax(0, seek.targetMs - 500), true);
+                    for (int step = 0; step < 1000 && video.currentPosition() * 1000 < seek.fromMs; step++) {
+                        video.stepFrame(1);
+                    }
+                } else if (seek.fromMs >= 0) {
+                    video.decodeUntilTarget(seek.fromMs, true);
+                }
+                qint64 decodedBefore = video.decodedFrames();
+                QElapsedTimer timer;
+                timer.start();
+                video.decodeUntilTarget(seek.targetMs, true);
+                latencies.append(timer.nsecsElapsed() / 1e6);
+                decoded += video.decodedFrames() - decodedBefore;
+
+                // 显示的应是目标时刻所在的那一帧（容差一帧，允许解码器按0.1秒放宽）
+                double shown = video.currentPosition();
+                double tolerance = qMax(frameMs, 100) / 1000.0;
+                if (shown < 0 || qAbs(shown - seek.targetMs / 1000.0) > tolerance) {
+                    wrong++;
+                }
+            }
+
+            std::sort(latencies.begin(), latencies.end());
+            qDebug().noquote() << QString("  %1 %2 %3 %4 %5 %6 %7 %8")
+                                  .arg(kind.name, -8)
+                                  .arg(latencies.size(), 6)
+                                  .arg(percentile(latencies, 0.5), 7, 'f', 1)
+                                  .arg(percentile(latencies, 0.9), 7, 'f', 1)
+                                  .arg(percentile(latencies, 0.99), 7, 'f', 1)
+                                  .arg(latencies.isEmpty() ? 0.0 : latencies.last(), 8, 'f', 1)
+                                  .arg(latencies.isEmpty() ? 0.0 : double(decoded) / latencies.size(), 10, 'f', 1)
+                                  .arg(wrong, 5);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+
+// 命令行基准测试（--bench <名称>），不打开窗口，结果输出到控制台
+class Benchmark
+{
+public:
+    // 返回进程退出码，0表示成功
+    static int run(const QString &name);
+
+private:
+    // 分条并行颜色转换：不同条数下的耗时和加速比
+    static int scaleBenchmark();
+    // 手写YUV转换（标量/AVX2）与swscale的速度对比
+    static int yuvBenchmark();
+    // 手写YUV转换的正确性：AVX2与标量逐字节一致，与swscale的PSNR达标
+    static int yuvCheck();
+    // 黄金帧回归：合成片段播放+跳转，逐帧CRC和pts与期望文件比对
+    static int goldenFrames();
+    // 音画同步：闪白/响声片段按不同倍速实时播放，统计画面与声音的偏差
+    static int avSync();
+    // 跳转延迟：随机/顺序前进/短距后退/跳到结尾，统计出第一帧正确画面的耗时分位数和每次解码帧数
+    static int seekLatency();
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,178 @@
+#include "conversioncache.h"
+#include "playerconfig.h"
+#include "memorybudget.h"
+#include <QDebug>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+bool ConversionKey::operator==(const ConversionKey &other) const
+{
+    return srcWidth == other.srcWidth && srcHeight == other.srcHeight &&
+            srcFormat == other.srcFormat && colorspace == other.colorspace &&
+            range == other.range && transfer == other.transfer && dstWidth == other.dstWidth &&
+            dstHeight == other.dstHeight && dstFormat == other.dstFormat;
+}
+
+Conversion::~Conversion()
+{
+    av_freep(&data[0]);
+    av_freep(&toneData[0]);
+    MemoryBudget::charge(MemoryBudget::Conversion, -bytes);
+}
+
+void Conversion::convert(const AVFrame *frame)
+{
+    if (tone.isValid()) {
+        if (scaler.isValid()) {
+            tone.convert(frame, toneData[0], toneLinesize[0]);
+            scaler.scale(toneData, toneLinesize, data, linesize);
+        } else {
+            tone.convert(frame, data[0], linesize[0]);
+        }
+    } else if (yuv.isValid()) {
+        yuv.convert(frame, data[0], linesize[0]);
+    } else {
+        scaler.scale(frame->data, frame->linesize, data, linesize);
+    }
+}
+
+ConversionCache::ConversionCache(int capacity)
+    : m_capacity(qMax(1, capacity))
+{
+}
+
+ConversionCache::~ConversionCache()
+{
+    clear();
+}
+
+void ConversionCache::clear()
+{
+    qDeleteAll(m_entries);
+    m_entries.clear();
+}
+
+Conversion *ConversionCache::acquire(const AVFrame *frame, int dstWidth, int dstHeight, AVPixelFormat dstFormat)
+{
+    ConversionKey key;
+    key.srcWidth = frame->width;
+    key.srcHeight = frame->height;
+    key.srcFormat = frame->format;
+    key.colorspace = frame->colorspace;
+    key.range = frame->color_range;
+    key.transfer = frame->color_trc;
+    key.dstWidth = dstWidth;
+    key.dstHeight = dstHeight;
+    key.dstFormat = dstFormat;
+
+    // 最多几项，顺序查找即可
+    for (Conversion *entry : m_entries) {
+        if (entry->key == key) {
+            entry->lastUsed = ++m_useCounter;
+            return entry;
+        }
+    }
+
+    Conversion *entry = create(key, frame);
+    if (!entry) {
+        return nullptr;
+    }
+    entry->bytes = av_image_get_buffer_size(dstFormat, dstWidth, dstHeight, 32);
+    if (entry->toneData[0]) {
+        entry->bytes += av_image_get_buffer_size(AV_PIX_FMT_RGB24, key.srcWidth, key.srcHeight, 32);
+    }
+    MemoryBudget::charge(MemoryBudget::Conversion, entry->bytes);
+
+    // 满了或超出总预算时淘汰最久没用的（新建的这个还没放进来，不会被淘汰）
+    while (!m_entries.isEmpty() && (m_entries.size() >= m_capacity || MemoryBudget::overBudget())) {
+        int oldest = 0;
+        for (int i = 1; i < m_entries.size(); i++) {
+            if (m_entries.at(i)->lastUsed < m_entries.at(oldest)->lastUsed) {
+                oldest = i;
+            }
+        }
+        delete m_entries.takeAt(oldest);
+    }
+    entry->lastUsed = ++m_useCounter;
+    m_entries.append(entry);
+    return entry;
+}
+
+Conversion *ConversionCache::create(const ConversionKey &key, const AVFrame *frame)
+{
+    AVPixelFormat srcFormat = (AVPixelFormat)key.srcFormat;
+    AVPixelFormat dstFormat = (AVPixelFormat)key.dstFormat;
+    AVColorSpace colorspace = (AVColorSpace)key.colorspace;
+    AVColorRange range = (AVColorRange)key.range;
+
+    qDebug() << "新建转换器：" << key.srcWidth << "x" << key.srcHeight
+             << av_get_pix_fmt_name(srcFormat) << av_color_space_name(colorspace)
+             << av_color_range_name(range)
+             << "->" << key.dstWidth << "x" << key.dstHeight << av_get_pix_fmt_name(dstFormat)
+             << "（已缓存" << m_entries.size() << "个）";
+
+    Conversion *entry = new Conversion;
+    entry->key = key;
+    if (av_image_alloc(entry->data, entry->linesize, key.dstWidth, key.dstHeight, dstFormat, 32) < 0) {
+        qDebug() << "错误：无法为转换输出分配内存";
+        delete entry;
+        return nullptr;
+    }
+
+    bool sameSize = (key.dstWidth == key.srcWidth && key.dstHeight == key.srcHeight);
+
+    // HDR：先在原尺寸上色调映射到SDR RGB24，需要缩小时再用swscale缩放
+    ToneMapper::Curve curve = ToneMapper::CurveHable;
+    if (ToneMapper::isHdr(key.transfer) && ToneMapper::supports(srcFormat) && dstFormat == AV_PIX_FMT_RGB24 &&
+            ToneMapper::curveFromName(PlayerConfig::tonemap, &curve)) {
+        double peakNits = PlayerConfig::hdrPeakNits;
+        if (peakNits <= 0) {
+            peakNits = ToneMapper::framePeakNits(frame);
+        }
+        if (peakNits <= 0) {
+            peakNits = 1000.0;
+        }
+
+        if (entry->tone.init(key.srcWidth, key.srcHeight, srcFormat,
+                             (AVColorTransferCharacteristic)key.transfer, range, curve, peakNits)) {
+            if (sameSize) {
+                return entry;
+            }
+            if (av_image_alloc(entry->toneData, entry->toneLinesize,
+                               key.srcWidth, key.srcHeight, AV_PIX_FMT_RGB24, 32) >= 0 &&
+                    entry->scaler.init(key.srcWidth, key.srcHeight, AV_PIX_FMT_RGB24,
+                                       key.dstWidth, key.dstHeight, dstFormat,
+                                       SWS_BILINEAR, PlayerConfig::scaleThreads)) {
+                return entry;
+            }
+            qDebug() << "色调映射后缩放失败，改用swscale直接转换";
+            entry->tone.release();
+            av_freep(&entry->toneData[0]);
+        }
+    }
+
+    // 不需要缩放且格式支持时用手写转换
+    if (sameSize && PlayerConfig::yuvKernel != "off" && YuvConverter::supports(srcFormat, dstFormat)) {
+        YuvConverter::Kernel kernel = (PlayerConfig::yuvKernel == "scalar")
+                ? YuvConverter::KernelScalar : YuvConverter::bestKernel();
+        if (entry->yuv.init(key.srcWidth, key.srcHeight, srcFormat, dstFormat, colorspace, range, kernel)) {
+            qDebug() << "颜色转换使用" << YuvConverter::kernelName(entry->yuv.kernel()) << "实现";
+            return entry;
+        }
+    }
+
+    if (!entry->scaler.init(key.srcWidth, key.srcHeight, srcFormat,
+                            key.dstWidth, key.dstHeight, dstFormat,
+                            SWS_BILINEAR, PlayerConfig::scaleThreads)) {
+        qDebug() << "错误：无法创建图像缩放转换器";
+        delete entry;
+        return nullptr;
+    }
+    entry->scaler.setColorspace(colorspace, range);
+    if (entry->scaler.bandCount() > 1) {
+        qDebug() << "颜色转换分" << entry->scaler.bandCount() << "条并行";
+    }
+    return entry;
+}
@@ -0,0 +1,62 @@
+#ifndef CONVERSIONCACHE_H
+#define CONVERSIONCACHE_H
+
+#include <QList>
+#include "slicescaler.h"
+#include "yuvconverter.h"
+#include "tonemapper.h"
+
+// 一组转换参数：输入的尺寸/格式/色彩空间/范围/传输特性，加上输出尺寸和格式
+struct ConversionKey {
+    int srcWidth = 0;
+    int srcHeight = 0;
+    int srcFormat = AV_PIX_FMT_NONE;
+    int colorspace = AVCOL_SPC_UNSPECIFIED;
+    int range = AVCOL_RANGE_UNSPECIFIED;
+    int transfer = AVCOL_TRC_UNSPECIFIED;
+    int dstWidth = 0;
+    int dstHeight = 0;
+    int dstFormat = AV_PIX_FMT_NONE;
+
+    bool operator==(const ConversionKey &other) const;
+};
+
+// 一个转换器和它的输出缓冲
+struct Conversion {
+    ConversionKey key;
+    ToneMapper tone;                // HDR画面先做色调映射（需要缩放时再交给scaler）
+    YuvConverter yuv;               // 有效时优先使用（不缩放的常见格式）
+    SliceScaler scaler;             // 其余情况交给swscale
+    uint8_t *data[4] = { nullptr };
+    int linesize[4] = { 0 };
+    uint8_t *toneData[4] = { nullptr };   // 色调映射后、缩放前的原尺寸RGB
+    int toneLinesize[4] = { 0 };
+    qint64 lastUsed = 0;
+    qint64 bytes = 0;               // 两块缓冲的大小（记在内存预算里）
+
+    ~Conversion();
+    void convert(const AVFrame *frame);
+};
+
+// 按帧的实际参数挑选转换器。码率自适应的录像、拼接的TS中途会换分辨率或格式，
+// 最近用过的几组都保留，来回切换时不用重建
+class ConversionCache
+{
+public:
+    explicit ConversionCache(int capacity = 4);
+    ~ConversionCache();
+
+    // 找到或新建匹配的转换器，满了淘汰最久没用的一个；失败返回nullptr
+    Conversion *acquire(const AVFrame *frame, int dstWidth, int dstHeight, AVPixelFormat dstFormat);
+    void clear();
+    int size() const { return m_entries.size(); }
+
+private:
+    Conversion *create(const ConversionKey &key, const AVFrame *frame);
+
+    QList<Conversion*> m_entries;
+    int m_capacity;
+    qint64 m_useCounter = 0;
+};
+
+#endif // CONVERSIONCACHE_H
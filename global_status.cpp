@@ -1,3 +0,0 @@
-#include "global_status.h"
-
-PlayerState GlobalVars::playerState = STATE_IDLE;
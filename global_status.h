@@ -6,12 +6,8 @@ enum PlayerState {
     STATE_READY,
     STATE_PLAYING,
     STATE_PAUSED,
-    STATE_ENDED
-};
-
-class GlobalVars {
-public:
-    static PlayerState playerState;
+    STATE_ENDED,
+    STATE_REVERSING
 };
 
 #endif
@@ -0,0 +1,97 @@
+#include "gopcache.h"
+#include "memorybudget.h"
+
+GopCache::GopCache()
+{
+}
+
+GopCache::~GopCache()
+{
+    clear();
+}
+
+void GopCache::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    if (!m_frames.isEmpty()) {
+        evict(m_frames.lastKey());
+    }
+}
+
+void GopCache::clear()
+{
+    for (AVFrame *frame : m_frames) {
+        m_pool.release(frame);
+    }
+    m_frames.clear();
+    MemoryBudget::charge(MemoryBudget::FrameCache, -m_used);
+    m_used = 0;
+}
+
+void GopCache::insert(const AVFrame *frame, int64_t pts)
+{
+    if (m_budget <= 0 || !frame || m_frames.contains(pts)) {
+        return;
+    }
+
+    AVFrame *copy = m_pool.ref(frame);
+    if (!copy) {
+        return;
+    }
+    copy->pts = pts;
+
+    qint64 bytes = frameBytes(copy);
+    m_frames.insert(pts, copy);
+    m_used += bytes;
+    MemoryBudget::charge(MemoryBudget::FrameCache, bytes);
+    evict(pts);
+}
+
+const AVFrame *GopCache::before(int64_t pts, int64_t *framePts) const
+{
+    auto it = m_frames.lowerBound(pts);
+    if (it == m_frames.constBegin()) {
+        return nullptr;
+    }
+    --it;
+    *framePts = it.key();
+    return it.value();
+}
+
+const AVFrame *GopCache::after(int64_t pts, int64_t *framePts) const
+{
+    auto it = m_frames.upperBound(pts);
+    if (it == m_frames.constEnd()) {
+        return nullptr;
+    }
+    *framePts = it.key();
+    return it.value();
+}
+
+qint64 GopCache::frameBytes(const AVFrame *frame)
+{
+    qint64 bytes = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i]; i++) {
+        bytes += frame->buf[i]->size;
+    }
+    return bytes;
+}
+
+// 超过自己的预算或总预算时淘汰，至少保留刚插入的那一帧
+void GopCache::evict(int64_t keepPts)
+{
+    while ((m_used > m_budget || MemoryBudget::overBudget()) && m_frames.size() > 1) {
+        int64_t first = m_frames.firstKey();
+        int64_t last = m_frames.lastKey();
+        int64_t victim = (keepPts - first > last - keepPts) ? first : last;
+        if (victim == keepPts) {
+            break;
+        }
+
+        AVFrame *frame = m_frames.take(victim);
+        qint64 bytes = frameBytes(frame);
+        m_used -= bytes;
+        MemoryBudget::charge(MemoryBudget::FrameCache, -bytes);
+        m_pool.release(frame);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef GOPCACHE_H
+#define GOPCACHE_H
+
+#include <QMap>
+#include "mediapool.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 已解码帧缓存：按pts排序，保存当前GOP附近连续的帧（只增加引用，不拷贝像素）
+// 超过内存预算时从离新插入帧最远的一端淘汰，缓存始终是一段连续的帧
+class GopCache
+{
+public:
+    GopCache();
+    ~GopCache();
+
+    void setBudget(qint64 bytes);
+    void clear();
+
+    // pts使用流的时间基
+    void insert(const AVFrame *frame, int64_t pts);
+    bool contains(int64_t pts) const { return m_frames.contains(pts); }
+
+    // 查找严格在pts之前/之后最近的帧，没有返回nullptr
+    const AVFrame *before(int64_t pts, int64_t *framePts) const;
+    const AVFrame *after(int64_t pts, int64_t *framePts) const;
+
+    int size() const { return m_frames.size(); }
+    qint64 memoryUsed() const { return m_used; }
+
+    // 帧引用的缓冲区总大小
+    static qint64 frameBytes(const AVFrame *frame);
+
+private:
+    void evict(int64_t keepPts);
+
+    FramePool m_pool;
+    QMap<int64_t, AVFrame*> m_frames;
+    qint64 m_budget = 0;
+    qint64 m_used = 0;
+};
+
+#endif // GOPCACHE_H
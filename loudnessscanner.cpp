@@ -0,0 +1,277 @@
+#include "loudnessscanner.h"
+#include "audiofilter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <cmath>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/dict.h>
+}
+
+double LoudnessInfo::gainFor(double targetLufs) const
+{
+    if (!valid) {
+        return 1.0;
+    }
+
+    double gainDb = targetLufs - integratedLufs;
+    // 峰值加上增益不能超过0dBFS
+    gainDb = qMin(gainDb, -peakDb);
+    gainDb = qBound(-20.0, gainDb, 20.0);
+    return std::pow(10.0, gainDb / 20.0);
+}
+
+LoudnessCache &LoudnessCache::instance()
+{
+    static LoudnessCache cache;
+    return cache;
+}
+
+LoudnessCache::LoudnessCache()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(dir);
+    m_cacheFile = QDir(dir).filePath("loudness.txt");
+    load();
+}
+
+QString LoudnessCache::fileKey(const QString &filePath)
+{
+    QFileInfo info(filePath);
+    return QString("%1|%2|%3")
+            .arg(info.absoluteFilePath())
+            .arg(info.size())
+            .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+bool LoudnessCache::lookup(const QString &filePath, LoudnessInfo *info)
+{
+    QString key = fileKey(filePath);
+    QMutexLocker locker(&m_mutex);
+    if (!m_entries.contains(key)) {
+        return false;
+    }
+    *info = m_entries.value(key);
+    return true;
+}
+
+void LoudnessCache::insert(const QString &filePath, const LoudnessInfo &info)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(fileKey(filePath), info);
+    save();
+}
+
+// 缓存文件每行：键\t整体响度\t峰值
+void LoudnessCache::load()
+{
+    QFile file(m_cacheFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split('\t');
+        if (fields.size() != 3) {
+            continue;
+        }
+        LoudnessInfo info;
+        info.integratedLufs = fields.at(1).toDouble();
+        info.peakDb = fields.at(2).toDouble();
+        info.valid = true;
+        m_entries.insert(fields.at(0), info);
+    }
+    qDebug() << "响度缓存已加载:" << m_entries.size() << "条";
+}
+
+void LoudnessCache::save()
+{
+    QSaveFile file(m_cacheFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "无法写入响度缓存:" << m_cacheFile;
+        return;
+    }
+
+    QTextStream out(&file);
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        out << it.key() << '\t' << it.value().integratedLufs << '\t' << it.value().peakDb << '\n';
+    }
+    out.flush();
+    file.commit();
+}
+
+LoudnessScanner::LoudnessScanner(QObject *parent) : QObject(parent)
+{
+    // 留一个核给播放
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+LoudnessScanner::~LoudnessScanner()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void LoudnessScanner::scanFile(const QString &filePath)
+{
+    LoudnessInfo cached;
+    if (LoudnessCache::instance().lookup(filePath, &cached)) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pending.contains(filePath)) {
+            return;
+        }
+        m_pending.insert(filePath);
+    }
+
+    QtConcurrent::run(&m_pool, [this, filePath]() {
+        LoudnessInfo info;
+        if (analyzeFile(filePath, &info)) {
+            LoudnessCache::instance().insert(filePath, info);
+            emit loudnessReady(filePath);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_pending.remove(filePath);
+    });
+}
+
+bool LoudnessScanner::analyzeFile(const QString &filePath, LoudnessInfo *info)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    AVFormatContext *formatCtx = nullptr;
+    AVCodecContext *codecCtx = nullptr;
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    AVFrame *filtered = nullptr;
+    AudioFilterGraph meter;
+    bool ok = false;
+    double lastLufs = 0.0;
+    double lastPeak = 0.0;
+    bool measured = false;
+
+    // 读出滤镜挂在帧上的测量值（ebur128的整体响度、astats的峰值）
+    auto collect = [&]() {
+        while (meter.receiveFrame(filtered) >= 0) {
+            AVDictionaryEntry *lufs = av_dict_get(filtered->metadata, "lavfi.r128.I", nullptr, 0);
+            AVDictionaryEntry *peak = av_dict_get(filtered->metadata, "lavfi.astats.Overall.Peak_level", nullptr, 0);
+            if (lufs && peak) {
+                lastLufs = atof(lufs->value);
+                lastPeak = atof(peak->value);
+                measured = true;
+            }
+            av_frame_unref(filtered);
+        }
+    };
+
+    do {
+        if (avformat_open_input(&formatCtx, filePath.toUtf8().constData(), nullptr, nullptr) < 0) {
+            break;
+        }
+        if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+            break;
+        }
+
+        int streamIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+        if (streamIndex < 0) {
+            break;
+        }
+
+        // 只解复用音频流，视频包直接在demuxer里丢掉
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+            if ((int)i != streamIndex) {
+                formatCtx->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
+        AVStream *stream = formatCtx->streams[streamIndex];
+        const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (!codec) {
+            break;
+        }
+        codecCtx = avcodec_alloc_context3(codec);
+        if (!codecCtx || avcodec_parameters_to_context(codecCtx, stream->codecpar) < 0) {
+            break;
+        }
+        if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
+            break;
+        }
+
+        int64_t layout = codecCtx->channel_layout;
+        if (layout == 0) {
+            layout = av_get_default_channel_layout(codecCtx->channels);
+        }
+        if (!meter.init("ebur128=metadata=1,astats=metadata=1:reset=0",
+                        codecCtx->sample_rate, codecCtx->sample_fmt, layout, stream->time_base)) {
+            break;
+        }
+
+        packet = av_packet_alloc();
+        frame = av_frame_alloc();
+        filtered = av_frame_alloc();
+        if (!packet || !frame || !filtered) {
+            break;
+        }
+
+        bool eof = false;
+        while (!eof) {
+            int ret = av_read_frame(formatCtx, packet);
+            if (ret < 0) {
+                eof = true;
+                avcodec_send_packet(codecCtx, nullptr);
+            } else if (packet->stream_index == streamIndex) {
+                avcodec_send_packet(codecCtx, packet);
+                av_packet_unref(packet);
+            } else {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            while (avcodec_receive_frame(codecCtx, frame) >= 0) {
+                if (frame->channel_layout == 0) {
+                    frame->channel_layout = layout;
+                }
+                meter.sendFrame(frame);
+                collect();
+            }
+        }
+
+        // 冲刷滤镜，最后一帧上的值就是整个文件的结果
+        meter.sendFrame(nullptr);
+        collect();
+        ok = measured;
+    } while (false);
+
+    if (ok) {
+        info->integratedLufs = lastLufs;
+        info->peakDb = lastPeak;
+        info->valid = true;
+        qDebug() << "响度扫描完成:" << QFileInfo(filePath).fileName()
+                 << lastLufs << "LUFS, 峰值" << lastPeak << "dBFS, 用时" << timer.elapsed() << "ms";
+    } else {
+        qDebug() << "响度扫描失败:" << filePath;
+    }
+
+    av_frame_free(&filtered);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codecCtx);
+    avformat_close_input(&formatCtx);
+    return ok;
+}
@@ -0,0 +1,65 @@
+#ifndef LOUDNESSSCANNER_H
+#define LOUDNESSSCANNER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
+
+// 一个文件的响度测量结果
+struct LoudnessInfo {
+    double integratedLufs = 0.0;   // 整体响度（LUFS）
+    double peakDb = 0.0;           // 采样峰值（dBFS）
+    bool valid = false;
+
+    // 按目标响度计算增益（线性倍数），保证峰值不削顶
+    double gainFor(double targetLufs) const;
+};
+
+// 响度缓存：按文件身份（路径+大小+修改时间）保存，跨次启动复用
+class LoudnessCache
+{
+public:
+    static LoudnessCache &instance();
+
+    bool lookup(const QString &filePath, LoudnessInfo *info);
+    void insert(const QString &filePath, const LoudnessInfo &info);
+
+    static QString fileKey(const QString &filePath);
+
+private:
+    LoudnessCache();
+    void load();
+    void save();
+
+    QMutex m_mutex;
+    QHash<QString, LoudnessInfo> m_entries;
+    QString m_cacheFile;
+};
+
+// 后台响度扫描：线程池里以尽可能快的速度解码音轨，测整体响度和峰值
+class LoudnessScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoudnessScanner(QObject *parent = nullptr);
+    ~LoudnessScanner();
+
+    // 已在缓存或正在扫描的文件会被跳过
+    void scanFile(const QString &filePath);
+
+    // 同步测量一个文件（在工作线程中调用）
+    static bool analyzeFile(const QString &filePath, LoudnessInfo *info);
+
+signals:
+    void loudnessReady(QString filePath);
+
+private:
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QSet<QString> m_pending;
+};
+
+#endif // LOUDNESSSCANNER_H
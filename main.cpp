@@ -1,10 +1,18 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include "playerconfig.h"
+#include "benchmark.h"
+#include "memorybudget.h"
 
 #undef main
 int main(int argc, char *argv[])
 {
         QApplication a(argc, argv);
+        PlayerConfig::parseArguments(a.arguments());
+        MemoryBudget::setLimit(PlayerConfig::memoryBudgetMB * 1024LL * 1024LL);
+        if (!PlayerConfig::benchmark.isEmpty()) {
+            return Benchmark::run(PlayerConfig::benchmark);
+        }
         MainWindow w;
         w.show();
         return a.exec();
@@ -22,8 +22,6 @@ MainWindow::MainWindow(QWidget *parent)
     ui->start_button->setIcon(QIcon(":/pictrues/start.png"));
 
 
-    GlobalVars::playerState = STATE_IDLE;
-
     connect(ui->seekSlider, &SeekSlider::valueChanged,
             this, &MainWindow::onSeekSliderMoved);
     connect(ui->seekSlider, &SeekSlider::sliderPressed,
@@ -36,25 +34,37 @@ MainWindow::MainWindow(QWidget *parent)
     t_video = new QThread;
     video->moveToThread(t_video);
     video->setDisplayWidget(ui->videoWidget);
-    connect(this,SIGNAL(init_video(QString)),video,SLOT(init_video(QString)));
     connect(video,SIGNAL(UpadatButton(bool)),this,SLOT(UpadatButton(bool)));//更新按钮状态、
-    connect(video,SIGNAL(UpadatStatus(QString,double)),this,SLOT(UpadatStatus(QString,double)));//更新滑动条时间状态
     connect(video,SIGNAL(UpadatseekSlider(double)),this,SLOT(UpadatseekSlider(double)));//更新滑动条最大状态显示
-    connect(this,SIGNAL(UpadatStatus()),video,SLOT(UpadatStatus()));//更新播放状态
-    connect(this,SIGNAL(UpadatSpeed(float)),video,SLOT(setPlaybackSpeed(float)));//更新播放速度
-    connect(this,SIGNAL(UpadatSeekSlider(int,int)),video,SLOT(setSeekSlider(int,int)));//拖动滑动条
+    connect(this,SIGNAL(displayResized(int,int)),video,SLOT(setDisplaySize(int,int)));//显示区域大小
+    ui->videoWidget->installEventFilter(this);
+    connect(video,&VideoThread::reverseFinished,this,[this]() { reverseSpeed = 0.0f; });
     t_video->start();
 
 
     audio = new AudioThread;
     t_audio = new QThread;
     audio->moveToThread(t_audio);
-    connect(this,SIGNAL(init_audio(QString)),audio,SLOT(init_audio(QString)));
-    connect(this,SIGNAL(UpadatStatus()),audio,SLOT(UpadatStatus()));//更新播放状态
-    connect(this,SIGNAL(setVolume(float)),audio,SLOT(setVolume(float)));//更新音量
-    connect(this,SIGNAL(UpadatSpeed(float)),audio,SLOT(setSpeed(float)));//更新播放速度
     t_audio->start();
 
+    // 打开/播放/暂停/跳转/倍速/音量/逐帧/倒放都经过播放引擎，由它在视频线程里合并后执行
+    // （快进结束后音频跟上视频位置也由引擎发起）
+    engine = new PlayerEngine(video, audio);
+    engine->moveToThread(t_video);
+
+    // 后台响度扫描，结果写入缓存后通知音频线程更新增益
+    loudnessScanner = new LoudnessScanner(this);
+    connect(loudnessScanner, &LoudnessScanner::loudnessReady,
+            audio, &AudioThread::onLoudnessReady);
+
+    // 后台生成波形概览，画在进度条后面
+    waveformBuilder = new WaveformBuilder(this);
+    connect(waveformBuilder, &WaveformBuilder::waveformReady,
+            this, &MainWindow::onWaveformReady);
+
+    // 后台镜头检测，上一个/下一个按镜头边界跳转
+    sceneDetector = new SceneDetector(this);
+
 
     video->setAudioReference(audio);
     ui->speed_button->setText(QString::number(speed) +"X");
@@ -64,6 +74,50 @@ MainWindow::MainWindow(QWidget *parent)
     ui->label_3->setVisible(true);
     ui->listWidget->setSpacing(3);
 
+    // 逐帧快捷键：. 下一帧，, 上一帧
+    QShortcut *nextFrameKey = new QShortcut(QKeySequence(Qt::Key_Period), this);
+    connect(nextFrameKey, &QShortcut::activated, this, [this]() { onStepFrame(1); });
+    QShortcut *prevFrameKey = new QShortcut(QKeySequence(Qt::Key_Comma), this);
+    connect(prevFrameKey, &QShortcut::activated, this, [this]() { onStepFrame(-1); });
+
+    // 倒放快捷键：J 倒放（连按在1x/2x/4x之间切换），K 停止倒放
+    QShortcut *reverseKey = new QShortcut(QKeySequence(Qt::Key_J), this);
+    connect(reverseKey, &QShortcut::activated, this, &MainWindow::onReverseKey);
+    QShortcut *reverseStopKey = new QShortcut(QKeySequence(Qt::Key_K), this);
+    connect(reverseStopKey, &QShortcut::activated, this, &MainWindow::onReverseStopKey);
+
+    // 播放位置：视频/音频线程只写原子量，这里每个屏幕刷新周期读一次，变了才更新界面
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal refreshRate = screen ? screen->refreshRate() : 60;
+    positionTimer = new QTimer(this);
+    positionTimer->setInterval(qBound(4, static_cast<int>(1000 / qMax<qreal>(refreshRate, 1)), 50));
+    connect(positionTimer, &QTimer::timeout, this, &MainWindow::updatePosition);
+    positionTimer->start();
+
+    // 播放统计：I 显示/隐藏，显示时每500ms刷新一次
+    statsTimer = new QTimer(this);
+    statsTimer->setInterval(500);
+    connect(statsTimer, &QTimer::timeout, this, &MainWindow::updateStats);
+    QShortcut *statsKey = new QShortcut(QKeySequence(Qt::Key_I), this);
+    connect(statsKey, &QShortcut::activated, this, &MainWindow::toggleStats);
+    if (PlayerConfig::showStats) {
+        toggleStats();
+    }
+
+    // 循环：L 整个文件循环开/关，B 依次设A点、设B点、取消A-B循环
+    QShortcut *loopKey = new QShortcut(QKeySequence(Qt::Key_L), this);
+    connect(loopKey, &QShortcut::activated, this, &MainWindow::toggleLoop);
+    QShortcut *loopMarkKey = new QShortcut(QKeySequence(Qt::Key_B), this);
+    connect(loopMarkKey, &QShortcut::activated, this, &MainWindow::onLoopMarkKey);
+    loopAll = PlayerConfig::loop;
+
+    // 滤镜：A 依次切换音频预设（均衡/夜间模式/响度标准化/关闭），D 反交错开/关
+    QShortcut *audioFilterKey = new QShortcut(QKeySequence(Qt::Key_A), this);
+    connect(audioFilterKey, &QShortcut::activated, this, &MainWindow::cycleAudioFilter);
+    QShortcut *deinterlaceKey = new QShortcut(QKeySequence(Qt::Key_D), this);
+    connect(deinterlaceKey, &QShortcut::activated, this, &MainWindow::toggleDeinterlace);
+    audioFilters = PlayerConfig::audioFilters;
+
 }
 
 MainWindow::~MainWindow()
@@ -71,22 +125,33 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    // 视频区域大小变化时通知视频线程按新尺寸转换
+    if (watched == ui->videoWidget && event->type() == QEvent::Resize) {
+        qreal ratio = ui->videoWidget->devicePixelRatioF();
+        emit displayResized(static_cast<int>(ui->videoWidget->width() * ratio),
+                            static_cast<int>(ui->videoWidget->height() * ratio));
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::onSeekSliderPressed()
 {
-    emit UpadatSeekSlider(0,0);
+    engine->seek(PlayerCommand::SeekHold, 0);
 }
 
 void MainWindow::onSeekSliderReleased()
 {
     int value = ui->seekSlider->value();
-    emit UpadatSeekSlider(2,value);
+    engine->seek(PlayerCommand::SeekCommit, value);
 }
 
 void MainWindow::onSeekSliderMoved(int value)
 {
     //    if(!m_isSeeking) return;
     //    static QElapsedTimer timer;
-    //    emit UpadatSeekSlider(1,value);
+    //    engine->seek(PlayerCommand::SeekScrub, value);
 }
 
 
@@ -106,8 +171,7 @@ void MainWindow::on_add_button_clicked()
     addVideoToPlaylist(filename);
 
     setstarting(filename);
-    emit init_video(filename);
-    emit init_audio(filename);
+    engine->open(filename);
 }
 
 void MainWindow::addVideoToPlaylist(const QString &filename)
@@ -146,6 +210,10 @@ void MainWindow::addVideoToPlaylist(const QString &filename)
             this, &MainWindow::onVideoPlayRequested);
     connect(widget, &VideoListItem::removeRequested,
             this, &MainWindow::onVideoRemoveRequested);
+
+    if (PlayerConfig::replayGain) {
+        loudnessScanner->scanFile(filename);
+    }
 }
 
 void MainWindow::onVideoPlayRequested(const QString &filePath)
@@ -155,7 +223,7 @@ void MainWindow::onVideoPlayRequested(const QString &filePath)
     ui->label->setVisible(false);
     ui->label_2->setVisible(false);
     ui->label_3->setVisible(false);
-    emit init_video(filePath);
+    engine->open(filePath);
 
 }
 
@@ -164,7 +232,7 @@ void MainWindow::onVideoRemoveRequested(const QString &filePath)
     // 1. 如果是当前正在播放的文件，先停止播放
     if (currentPlayingFile == filePath) {
         ui->start_button->setIcon(QIcon(":/pictrues/start.png"));
-        emit UpadatSeekSlider(0,0);
+        engine->seek(PlayerCommand::SeekHold, 0);
     }
 
     // 2. 从播放列表中移除
@@ -178,7 +246,13 @@ void MainWindow::onVideoRemoveRequested(const QString &filePath)
 
 void MainWindow::on_start_button_clicked()
 {
-    switch (GlobalVars::playerState)
+    // 倒放中按播放：先停止倒放，回到正常播放
+    if (reverseSpeed > 0) {
+        onReverseStopKey();
+    }
+
+    // 状态由引擎改，这里只按当前状态决定发什么命令
+    switch (PlayerEngine::state())
     {
     case STATE_IDLE:
         // 还没打开文件，先打开
@@ -186,29 +260,20 @@ void MainWindow::on_start_button_clicked()
         break;
 
     case STATE_READY:
-        // 文件已就绪，开始播放
+    case STATE_PAUSED:
+    case STATE_ENDED:
+    case STATE_REVERSING:
+        // 开始/继续/从头播放
         ui->start_button->setIcon(QIcon(":/pictrues/stop.png"));
-
+        engine->play();
         break;
 
     case STATE_PLAYING:
         // 正在播放，暂停
         ui->start_button->setIcon(QIcon(":/pictrues/start.png"));
-        GlobalVars::playerState = STATE_PAUSED;
-        break;
-
-    case STATE_PAUSED:
-        // 已暂停，继续播放
-        ui->start_button->setIcon(QIcon(":/pictrues/stop.png"));
-        GlobalVars::playerState = STATE_PLAYING;
-        break;
-
-    case STATE_ENDED:
-        // 播放结束，重新开始
-        ui->start_button->setIcon(QIcon(":/pictrues/stop.png"));
+        engine->pause();
         break;
     }
-    emit UpadatStatus();
 }
 
 void MainWindow::UpadatButton(bool flag)
@@ -216,11 +281,23 @@ void MainWindow::UpadatButton(bool flag)
     ui->start_button->setIcon(QIcon(QString(":/pictrues/%1.png").arg(flag ? "stop" : "start")));
 }
 
-void MainWindow::UpadatStatus(QString time,double value)
+void MainWindow::updatePosition()
 {
-    current_time = time.section('/', 0, 0);
-    ui->time_label->setText(time);
-    ui->seekSlider->setValue(value);
+    qint64 positionMs = PlaybackStats::positionMs.loadAcquire();
+    if (positionMs == shownPositionMs) {
+        return;
+    }
+    shownPositionMs = positionMs;
+    current_position_ms = positionMs;
+
+    int currentTime = static_cast<int>(positionMs / 1000);
+    QString timeText = QString("%1:%2 / %3:%4")
+            .arg(currentTime / 60, 2, 10, QChar('0'))
+            .arg(currentTime % 60, 2, 10, QChar('0'))
+            .arg(totall_time / 60, 2, 10, QChar('0'))
+            .arg(totall_time % 60, 2, 10, QChar('0'));
+    ui->time_label->setText(timeText);
+    ui->seekSlider->setValue(static_cast<int>(positionMs));
 }
 
 void MainWindow::UpadatseekSlider(double value)
@@ -240,6 +317,12 @@ void MainWindow::on_speed_button_clicked()
     } else if (qFuzzyCompare(speed, 1.5f)) {
         speed = 2.0f;
     } else if (qFuzzyCompare(speed, 2.0f)) {
+        speed = 4.0f;   // 2倍以上为快进：视频跳帧解码，音频静音
+    } else if (qFuzzyCompare(speed, 4.0f)) {
+        speed = 8.0f;
+    } else if (qFuzzyCompare(speed, 8.0f)) {
+        speed = 16.0f;
+    } else if (qFuzzyCompare(speed, 16.0f)) {
         speed = 0.5f;
     } else {
         // 默认值
@@ -257,40 +340,41 @@ void MainWindow::on_speed_button_clicked()
     }
 
     qDebug() << "speed:" << speed;
-    emit UpadatSpeed(speed);
+    engine->setSpeed(speed);
 
 }
 
 void MainWindow::on_private_button_pressed()
 {
-    emit UpadatSeekSlider(0,0);
+    engine->seek(PlayerCommand::SeekHold, 0);
 }
 
 void MainWindow::on_private_button_released()
 {
-    int minutes = current_time.section(':', 0, 0).toInt();
-    int seconds = current_time.section(':', 1, 1).toInt();
-    int current_seconds = minutes * 60 + seconds;
-    int total_second_n = 0;
+    double current_seconds = current_position_ms / 1000.0;
+    double target = 0;
 
-    total_second_n = (current_seconds - time < 0) ? 0 :(current_seconds - time);
-    emit UpadatSeekSlider(2,total_second_n * 1000);
+    // 优先跳到镜头切换点/章节，没有索引时按固定步长
+    if (!sceneDetector->previousBoundary(currentPlayingFile, current_seconds, &target)) {
+        target = (current_seconds - time < 0) ? 0 : (current_seconds - time);
+    }
+    engine->seek(PlayerCommand::SeekCommit, static_cast<qint64>(target * 1000));
 }
 
 void MainWindow::on_next_button_pressed()
 {
-    emit UpadatSeekSlider(0,0);
+    engine->seek(PlayerCommand::SeekHold, 0);
 }
 
 void MainWindow::on_next_button_released()
 {
-    int minutes = current_time.section(':', 0, 0).toInt();
-    int seconds = current_time.section(':', 1, 1).toInt();
-    int current_seconds = minutes * 60 + seconds;
-    int total_second_n = 0;
+    double current_seconds = current_position_ms / 1000.0;
+    double target = 0;
 
-    total_second_n = (current_seconds + time > totall_time) ? totall_time :(current_seconds + time);
-    emit UpadatSeekSlider(2,total_second_n * 1000);
+    if (!sceneDetector->nextBoundary(currentPlayingFile, current_seconds, &target)) {
+        target = (current_seconds + time > totall_time) ? totall_time : (current_seconds + time);
+    }
+    engine->seek(PlayerCommand::SeekCommit, static_cast<qint64>(target * 1000));
 }
 
 void MainWindow::setstarting(const QString &filePath)
@@ -321,13 +405,128 @@ void MainWindow::setstarting(const QString &filePath)
 
     currentPlayingFile = filePath;
     currentPlayIndex = targetIndex;
+
+    ui->seekSlider->clearWaveform();
+    waveformBuilder->build(filePath);
+    sceneDetector->detect(filePath);
+
+    // A-B点只对原来的文件有效
+    loopA = -1;
+    loopB = -1;
+    applyLoop();
+}
+
+void MainWindow::onStepFrame(int direction)
+{
+    // 逐帧时引擎先暂停
+    if (PlayerEngine::state() == STATE_PLAYING) {
+        ui->start_button->setIcon(QIcon(":/pictrues/start.png"));
+    }
+    engine->step(direction);
+}
+
+void MainWindow::onReverseKey()
+{
+    // 倒放时音频静音（引擎先暂停播放）
+    if (PlayerEngine::state() == STATE_PLAYING) {
+        ui->start_button->setIcon(QIcon(":/pictrues/start.png"));
+    }
+
+    reverseSpeed = (reverseSpeed <= 0 || reverseSpeed >= 4.0f) ? 1.0f : reverseSpeed * 2;
+    engine->reverse(reverseSpeed);
+}
+
+void MainWindow::onReverseStopKey()
+{
+    if (reverseSpeed <= 0) {
+        return;
+    }
+    reverseSpeed = 0.0f;
+    engine->reverse(0.0f);
+}
+
+void MainWindow::toggleStats()
+{
+    // 视频区域的原生窗口归SDL管，叠在上面的控件显示不稳定，统计写在顶部状态栏里
+    if (statsTimer->isActive()) {
+        statsTimer->stop();
+        ui->statusLabel->clear();
+        ui->statusLabel->setFont(statusFont);
+        ui->statusLabel->setAlignment(statusAlignment);
+        return;
+    }
+
+    statusFont = ui->statusLabel->font();
+    statusAlignment = ui->statusLabel->alignment();
+    QFont statsFont = statusFont;
+    statsFont.setPointSize(9);
+    statsFont.setBold(false);
+    ui->statusLabel->setFont(statsFont);
+    ui->statusLabel->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
+
+    lastStats = PlaybackStats::snapshot();
+    statsClock.start();
+    statsTimer->start();
+    updateStats();
+}
+
+void MainWindow::updateStats()
+{
+    PlaybackStats::Snapshot stats = PlaybackStats::snapshot();
+    double seconds = statsClock.restart() / 1000.0;
+    if (seconds <= 0) {
+        seconds = 0.001;
+    }
+
+    qint64 decoded = stats.decodedFrames - lastStats.decodedFrames;
+    qint64 presented = stats.presentedFrames - lastStats.presentedFrames;
+    double kbps = (stats.videoBytes - lastStats.videoBytes) * 8 / 1000.0 / seconds;
+    double convertMs = 0;
+    double toneMs = 0;
+    double presentMs = 0;
+    if (presented > 0) {
+        convertMs = (stats.convertNs - lastStats.convertNs) / 1e6 / presented;
+        toneMs = (stats.toneNs - lastStats.toneNs) / 1e6 / presented;
+        presentMs = (stats.presentNs - lastStats.presentNs) / 1e6 / presented;
+    }
+    lastStats = stats;
+
+    QString text = QString("解码 %1 fps  显示 %2 fps  丢帧 %3  晚帧 %4  码率 %5 kbps\n")
+            .arg(decoded / seconds, 0, 'f', 1)
+            .arg(presented / seconds, 0, 'f', 1)
+            .arg(stats.droppedFrames)
+            .arg(stats.lateFrames)
+            .arg(kbps, 0, 'f', 0);
+    text += QString("帧缓存 %1 帧  音频队列 %2 ms  音画差 %3 ms  音频欠载 %4\n")
+            .arg(stats.frameCacheFrames)
+            .arg(stats.audioQueueMs)
+            .arg(stats.avDiffUs / 1000.0, 0, 'f', 1)
+            .arg(stats.audioUnderruns);
+    text += QString("颜色转换 %1 ms/帧（色调映射 %2）  输出 %3 ms/帧  画面 %4 ms  音频时钟 %5 ms")
+            .arg(convertMs, 0, 'f', 2)
+            .arg(toneMs, 0, 'f', 2)
+            .arg(presentMs, 0, 'f', 2)
+            .arg(stats.positionMs)
+            .arg(stats.audioClockMs);
+    text += "\n" + MemoryBudget::report();
+    ui->statusLabel->setText(text);
+}
+
+void MainWindow::onWaveformReady(QString filePath)
+{
+    if (filePath != currentPlayingFile) {
+        return;
+    }
+
+    WaveformData data = waveformBuilder->waveform(filePath);
+    ui->seekSlider->setWaveform(data.mins, data.maxs);
 }
 
 
 void MainWindow::on_del_button_pressed()
 {
     ui->start_button->setIcon(QIcon(":/pictrues/start.png"));
-    emit UpadatSeekSlider(0,0);
+    engine->seek(PlayerCommand::SeekHold, 0);
 }
 
 void MainWindow::on_del_button_released()
@@ -344,6 +543,72 @@ void MainWindow::on_horizontalSlider_valueChanged(int value)
 {
     // 将 0-300 映射到 0.0-3.0
     float floatValue = value / 100.0f;
-    emit setVolume(floatValue);
+    engine->setVolume(floatValue);
+}
+
+void MainWindow::toggleLoop()
+{
+    loopAll = !loopAll;
+    applyLoop();
+}
+
+void MainWindow::onLoopMarkKey()
+{
+    if (loopA < 0) {
+        loopA = current_position_ms;
+    } else if (loopB < 0 && current_position_ms > loopA) {
+        loopB = current_position_ms;
+    } else {
+        loopA = -1;
+        loopB = -1;
+    }
+    applyLoop();
 }
 
+void MainWindow::applyLoop()
+{
+    QString text;
+    if (loopA >= 0 && loopB >= 0) {
+        engine->setLoop(loopA, loopB);
+        text = QString("A-B循环 %1s ~ %2s").arg(loopA / 1000.0, 0, 'f', 1).arg(loopB / 1000.0, 0, 'f', 1);
+    } else {
+        // 只设了A点时还按原来的方式播，等设好B点
+        engine->setLoop(loopAll ? 0 : -1, -1);
+        if (loopA >= 0) {
+            text = QString("A点 %1s，再按B设B点").arg(loopA / 1000.0, 0, 'f', 1);
+        } else {
+            text = loopAll ? "循环播放" : "";
+        }
+    }
+    qDebug() << "循环设置：" << (text.isEmpty() ? QString("关闭") : text);
+    showStatus(text);
+}
+
+void MainWindow::cycleAudioFilter()
+{
+    static const QStringList presets = { "", "eq", "night", "loudnorm" };
+    // 启动时给的是自定义滤镜链时，从第一个预设开始
+    int index = presets.indexOf(audioFilters);
+    audioFilters = presets.at((index + 1) % presets.size());
+    engine->setAudioFilters(audioFilters);
+    showStatus(audioFilters.isEmpty() ? "音频滤镜关闭" : "音频滤镜：" + audioFilters);
+}
+
+void MainWindow::toggleDeinterlace()
+{
+    deinterlace = !deinterlace;
+    QString filters = PlayerConfig::videoFilters;
+    if (deinterlace) {
+        filters = filters.isEmpty() ? "yadif" : "yadif," + filters;
+    }
+    engine->setVideoFilters(filters);
+    showStatus(deinterlace ? "反交错开" : "反交错关");
+}
+
+void MainWindow::showStatus(const QString &text)
+{
+    // 统计面板占着状态栏时不覆盖
+    if (!statsTimer->isActive()) {
+        ui->statusLabel->setText(text);
+    }
+}
@@ -8,14 +8,24 @@
 #include <QDebug>
 #include <QDesktopServices>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QQueue>
 #include <QDateTime>
 #include <QtConcurrent>
+#include <QShortcut>
+#include <QScreen>
+#include <QGuiApplication>
 #include "videothread.h"
 #include "audiothread.h"
-#include "global_status.h"
+#include "playerengine.h"
 #include "videolistitem.h"
+#include "loudnessscanner.h"
+#include "waveformbuilder.h"
+#include "scenedetector.h"
+#include "playbackstats.h"
+#include "memorybudget.h"
+#include "playerconfig.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -51,7 +61,7 @@ private slots:
 
     void UpadatButton(bool flag);
 
-    void UpadatStatus(QString time,double value);
+    void updatePosition();
 
     void UpadatseekSlider(double value);
 
@@ -86,19 +96,34 @@ private slots:
 
     void on_horizontalSlider_valueChanged(int value);
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
-signals:
-    void init_video(QString filename);
+private slots:
+
+    void onWaveformReady(QString filePath);
+
+    void onStepFrame(int direction);
+
+    void onReverseKey();
+
+    void onReverseStopKey();
 
-    void init_audio(QString filename);
+    void toggleStats();
 
-    void UpadatStatus();
+    void updateStats();
 
-    void UpadatSpeed(float speed);
+    void toggleLoop();
 
-    void UpadatSeekSlider(int,int);
+    void onLoopMarkKey();
 
-    void setVolume(float volume);
+    void cycleAudioFilter();
+
+    void toggleDeinterlace();
+
+
+signals:
+    void displayResized(int width, int height);
 
 
 private:
@@ -110,16 +135,38 @@ private:
     QThread *t_video = nullptr;
     AudioThread *audio = nullptr;
     QThread *t_audio = nullptr;
+    PlayerEngine *engine = nullptr;  //播放控制都投递给它（在视频线程里执行）
+    LoudnessScanner *loudnessScanner = nullptr;
+    WaveformBuilder *waveformBuilder = nullptr;
+    SceneDetector *sceneDetector = nullptr;
     float speed = 1.0f;
+    float reverseSpeed = 0.0f;  //倒放速度，0表示没有倒放
 
 
-    QString current_time = nullptr;
-    int time = 0;  //一次前进后退的时间间隔
+    qint64 current_position_ms = 0;  //当前播放位置
+    int time = 0;  //没有镜头/章节索引时一次前进后退的时间间隔
     int totall_time = 0;  //总时长
 
     QString currentPlayingFile = nullptr;
     int currentPlayIndex = 0;
 
+    QTimer *positionTimer = nullptr;  //按屏幕刷新率读播放位置
+    qint64 shownPositionMs = -1;  //界面上已经显示的位置
+    QTimer *statsTimer = nullptr;  //统计面板刷新（只在显示时运行）
+    PlaybackStats::Snapshot lastStats;  //上次刷新时的快照，用来算速率
+    QElapsedTimer statsClock;
+    QFont statusFont;  //显示统计前状态栏的字体和对齐
+    Qt::Alignment statusAlignment;
+
+    bool loopAll = false;  //整个文件循环
+    qint64 loopA = -1;  //A-B循环的两个点（毫秒），-1表示还没设
+    qint64 loopB = -1;
+    void applyLoop();  //把当前循环设置交给引擎
+
+    QString audioFilters;  //当前音频滤镜（预设名或滤镜链）
+    bool deinterlace = false;  //在启动时的视频滤镜后面加反交错
+    void showStatus(const QString &text);  //状态栏提示（统计面板显示时不覆盖）
+
 
 
 
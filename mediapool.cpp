@@ -0,0 +1,83 @@
+#include "mediapool.h"
+
+// 池里留的空闲结构体上限（回看缓冲整段清空时不必全部留着）
+static const int MAX_FREE_PACKETS = 1024;
+static const int MAX_FREE_FRAMES = 256;
+
+PacketPool::~PacketPool()
+{
+    for (AVPacket *packet : m_free) {
+        av_packet_free(&packet);
+    }
+}
+
+AVPacket *PacketPool::ref(const AVPacket *src)
+{
+    AVPacket *packet = nullptr;
+    if (!m_free.isEmpty()) {
+        packet = m_free.takeLast();
+    } else {
+        packet = av_packet_alloc();
+        if (!packet) {
+            return nullptr;
+        }
+    }
+
+    if (av_packet_ref(packet, src) < 0) {
+        m_free.append(packet);
+        return nullptr;
+    }
+    return packet;
+}
+
+void PacketPool::release(AVPacket *packet)
+{
+    if (!packet) {
+        return;
+    }
+    av_packet_unref(packet);
+    if (m_free.size() < MAX_FREE_PACKETS) {
+        m_free.append(packet);
+    } else {
+        av_packet_free(&packet);
+    }
+}
+
+FramePool::~FramePool()
+{
+    for (AVFrame *frame : m_free) {
+        av_frame_free(&frame);
+    }
+}
+
+AVFrame *FramePool::ref(const AVFrame *src)
+{
+    AVFrame *frame = nullptr;
+    if (!m_free.isEmpty()) {
+        frame = m_free.takeLast();
+    } else {
+        frame = av_frame_alloc();
+        if (!frame) {
+            return nullptr;
+        }
+    }
+
+    if (av_frame_ref(frame, src) < 0) {
+        m_free.append(frame);
+        return nullptr;
+    }
+    return frame;
+}
+
+void FramePool::release(AVFrame *frame)
+{
+    if (!frame) {
+        return;
+    }
+    av_frame_unref(frame);
+    if (m_free.size() < MAX_FREE_FRAMES) {
+        m_free.append(frame);
+    } else {
+        av_frame_free(&frame);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MEDIAPOOL_H
+#define MEDIAPOOL_H
+
+#include <QList>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+// 播放热路径上的复用池：复用缓存用来持有引用的AVPacket/AVFrame结构体。
+// 包和帧的数据缓冲本来就是引用计数的（解复用器、解码器内部有自己的池），
+// 但每次引用FFmpeg仍会分配AVBufferRef，所以这里只是少分配，做不到零分配；
+// 只在一个线程里用，不加锁
+
+class PacketPool
+{
+public:
+    ~PacketPool();
+
+    // 取一个空闲的包（没有时新建）并引用src的数据，失败返回nullptr
+    AVPacket *ref(const AVPacket *src);
+    // 解除引用后放回池里
+    void release(AVPacket *packet);
+
+private:
+    QList<AVPacket*> m_free;
+};
+
+class FramePool
+{
+public:
+    ~FramePool();
+
+    AVFrame *ref(const AVFrame *src);
+    void release(AVFrame *frame);
+
+private:
+    QList<AVFrame*> m_free;
+};
+
+#endif // MEDIAPOOL_H
@@ -0,0 +1,78 @@
+#include "memorybudget.h"
+#include <QStringList>
+
+QAtomicInteger<qint64> MemoryBudget::s_limit;
+QAtomicInteger<qint64> MemoryBudget::s_used[MemoryBudget::ComponentCount];
+
+void MemoryBudget::setLimit(qint64 bytes)
+{
+    s_limit.storeRelease(qMax<qint64>(0, bytes));
+}
+
+qint64 MemoryBudget::limit()
+{
+    return s_limit.loadAcquire();
+}
+
+void MemoryBudget::charge(Component component, qint64 bytes)
+{
+    if (bytes != 0) {
+        s_used[component].fetchAndAddRelaxed(bytes);
+    }
+}
+
+qint64 MemoryBudget::used(Component component)
+{
+    return s_used[component].loadAcquire();
+}
+
+qint64 MemoryBudget::totalUsed()
+{
+    qint64 total = 0;
+    for (int i = 0; i < ComponentCount; i++) {
+        total += s_used[i].loadAcquire();
+    }
+    return total;
+}
+
+bool MemoryBudget::overBudget()
+{
+    qint64 bytes = limit();
+    return bytes > 0 && totalUsed() > bytes;
+}
+
+const char *MemoryBudget::componentName(Component component)
+{
+    switch (component) {
+    case FrameCache:   return "逐帧";
+    case SeekBack:     return "回看";
+    case LoopHead:     return "循环";
+    case ReverseCache: return "倒放";
+    case PcmQueue:     return "PCM";
+    case Conversion:   return "转换";
+    default:           return "?";
+    }
+}
+
+QString MemoryBudget::report()
+{
+    const double mb = 1024.0 * 1024.0;
+    QStringList parts;
+    for (int i = 0; i < ComponentCount; i++) {
+        qint64 bytes = used(static_cast<Component>(i));
+        if (bytes > 0) {
+            parts << QString("%1 %2").arg(componentName(static_cast<Component>(i)))
+                     .arg(bytes / mb, 0, 'f', 1);
+        }
+    }
+
+    QString total = QString("内存 %1").arg(totalUsed() / mb, 0, 'f', 1);
+    if (limit() > 0) {
+        total += QString("/%1").arg(limit() / mb, 0, 'f', 0);
+    }
+    total += " MB";
+    if (!parts.isEmpty()) {
+        total += "（" + parts.join("，") + "）";
+    }
+    return total;
+}
@@ -0,0 +1,42 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QAtomicInteger>
+#include <QString>
+
+// 进程内的内存总预算：各个队列和缓存分配/释放时在这里记账（原子累加，不加锁）。
+// 超出预算时，可以丢的缓存（逐帧缓存、回看缓冲、转换器）各自淘汰到最小，
+// 倒放预取暂停等待（反压）；PCM队列、循环起点缓存只记账，不受限制
+class MemoryBudget
+{
+public:
+    enum Component {
+        FrameCache,         // 逐帧缓存（已解码帧）
+        SeekBack,           // 回看缓冲（视频包）
+        LoopHead,           // 循环起点缓存（视频包）
+        ReverseCache,       // 倒放预取的已解码帧
+        PcmQueue,           // 音频PCM队列
+        Conversion,         // 颜色转换输出缓冲
+        ComponentCount
+    };
+
+    // 总预算（字节），0表示不限制
+    static void setLimit(qint64 bytes);
+    static qint64 limit();
+
+    // bytes为正是分配，为负是释放
+    static void charge(Component component, qint64 bytes);
+    static qint64 used(Component component);
+    static qint64 totalUsed();
+    static bool overBudget();
+
+    static const char *componentName(Component component);
+    // 各部分用量（MB），统计面板显示
+    static QString report();
+
+private:
+    static QAtomicInteger<qint64> s_limit;
+    static QAtomicInteger<qint64> s_used[ComponentCount];
+};
+
+#endif // MEMORYBUDGET_H
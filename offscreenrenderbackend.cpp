@@ -0,0 +1,106 @@
+#include "offscreenrenderbackend.h"
+#include <QDebug>
+
+extern "C" {
+#include <libavutil/crc.h>
+#include <libavutil/time.h>
+}
+
+bool OffscreenRenderBackend::open()
+{
+    QMutexLocker locker(&m_mutex);
+    m_frames.clear();
+    m_frameCount = 0;
+    m_lastFrame = QImage();
+    qDebug() << "离屏输出：不显示画面，只记录每帧校验值";
+    return true;
+}
+
+void OffscreenRenderBackend::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_frameCount > 0) {
+        qDebug() << "离屏输出结束：" << m_frameCount << "帧，最后一帧CRC"
+                 << QString::number(m_frames.at((m_frameCount - 1) % MAX_FRAMES).crc, 16);
+    }
+}
+
+bool OffscreenRenderBackend::present(const uint8_t *data, int linesize, int width, int height, double displayAspect)
+{
+    Q_UNUSED(displayAspect);
+    Frame frame;
+    frame.presentUs = av_gettime_relative();
+    frame.crc = frameCrc(data, linesize, width, height);
+    const uint8_t *center = data + (ptrdiff_t)(height / 2) * linesize + (width / 2) * 3;
+    frame.brightness = (center[0] + 2 * center[1] + center[2]) / 4;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_frames.size() < MAX_FRAMES) {
+        m_frames.append(frame);
+    } else {
+        m_frames[m_frameCount % MAX_FRAMES] = frame;
+    }
+    m_frameCount++;
+    if (m_keepLastFrame) {
+        m_lastFrame = QImage(data, width, height, linesize, QImage::Format_RGB888).copy();
+    }
+    return true;
+}
+
+void OffscreenRenderBackend::setKeepLastFrame(bool keep)
+{
+    QMutexLocker locker(&m_mutex);
+    m_keepLastFrame = keep;
+}
+
+int OffscreenRenderBackend::frameCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameCount;
+}
+
+quint32 OffscreenRenderBackend::lastCrc()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameCount > 0 ? m_frames.at((m_frameCount - 1) % MAX_FRAMES).crc : 0;
+}
+
+QVector<quint32> OffscreenRenderBackend::frameCrcs()
+{
+    QVector<quint32> crcs;
+    for (const Frame &frame : frames()) {
+        crcs.append(frame.crc);
+    }
+    return crcs;
+}
+
+QVector<OffscreenRenderBackend::Frame> OffscreenRenderBackend::frames()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_frameCount <= MAX_FRAMES) {
+        return m_frames;
+    }
+    // 已经绕回：从最旧的一帧开始排
+    QVector<Frame> ordered;
+    ordered.reserve(MAX_FRAMES);
+    for (int i = 0; i < MAX_FRAMES; i++) {
+        ordered.append(m_frames.at((m_frameCount + i) % MAX_FRAMES));
+    }
+    return ordered;
+}
+
+QImage OffscreenRenderBackend::lastFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastFrame;
+}
+
+quint32 OffscreenRenderBackend::frameCrc(const uint8_t *data, int linesize, int width, int height)
+{
+    const AVCRC *table = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    uint32_t crc = 0xffffffff;
+    for (int y = 0; y < height; y++) {
+        crc = av_crc(table, crc, data + (ptrdiff_t)y * linesize, (size_t)width * 3);
+    }
+    return crc ^ 0xffffffff;
+}
@@ -0,0 +1,50 @@
+#ifndef OFFSCREENRENDERBACKEND_H
+#define OFFSCREENRENDERBACKEND_H
+
+#include "renderbackend.h"
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+
+// 不显示，只对每帧算CRC32、记下交来的时刻（只留最近MAX_FRAMES帧，可选保留最后一帧），
+// 用于无窗口运行、基准测试和画面比对
+class OffscreenRenderBackend : public RenderBackend
+{
+public:
+    struct Frame {
+        quint32 crc;
+        qint64 presentUs;               // 交来显示的时刻（av_gettime_relative，微秒）
+        int brightness;                 // 画面中心像素的亮度（0~255），音画同步测量用来找闪白
+    };
+
+    const char *name() const override { return "offscreen"; }
+    bool open() override;
+    void close() override;
+    bool present(const uint8_t *data, int linesize, int width, int height, double displayAspect) override;
+
+    // 保留最后一帧的拷贝（默认只算校验值）
+    void setKeepLastFrame(bool keep);
+
+    // 打开以来交来的总帧数（不受保留上限影响）
+    int frameCount();
+    quint32 lastCrc();
+    // 保留下来的最近几帧，按时间先后
+    QVector<quint32> frameCrcs();
+    QVector<Frame> frames();
+    QImage lastFrame();
+
+    // 一帧RGB24可见像素（不含行尾对齐）的CRC32
+    static quint32 frameCrc(const uint8_t *data, int linesize, int width, int height);
+
+private:
+    // 长时间无窗口播放时记录不能无限增长，约25fps下3分钟
+    static const int MAX_FRAMES = 4096;
+
+    QMutex m_mutex;                 // 视频线程写，其他线程读
+    QVector<Frame> m_frames;        // 环形，写满后覆盖最旧的
+    int m_frameCount = 0;
+    bool m_keepLastFrame = false;
+    QImage m_lastFrame;
+};
+
+#endif // OFFSCREENRENDERBACKEND_H
@@ -0,0 +1,134 @@
+#include "packetring.h"
+#include "memorybudget.h"
+
+PacketRing::PacketRing()
+{
+}
+
+PacketRing::~PacketRing()
+{
+    clear();
+}
+
+void PacketRing::setLimits(qint64 bytes, int64_t duration)
+{
+    m_maxBytes = bytes;
+    m_maxDuration = duration;
+    if (m_maxBytes <= 0 || m_maxDuration <= 0) {
+        clear();
+    } else {
+        evict();
+    }
+}
+
+void PacketRing::clear()
+{
+    for (AVPacket *packet : m_packets) {
+        m_pool.release(packet);
+    }
+    m_packets.clear();
+    m_keys.clear();
+    m_firstSeq = 0;
+    m_cursor = 0;
+    m_lastPts = AV_NOPTS_VALUE;
+    MemoryBudget::charge(MemoryBudget::SeekBack, -m_used);
+    m_used = 0;
+}
+
+void PacketRing::append(const AVPacket *packet)
+{
+    if (m_maxBytes <= 0 || m_maxDuration <= 0) {
+        // 不缓存时只可能剩下回放完的循环起点，接着读文件了就不用再留
+        if (!m_packets.isEmpty()) {
+            clear();
+        }
+        return;
+    }
+
+    bool key = (packet->flags & AV_PKT_FLAG_KEY) && packet->pts != AV_NOPTS_VALUE;
+    // 缓冲总是从关键帧开始，前面没法单独解码的包不要
+    if (m_packets.isEmpty() && !key) {
+        return;
+    }
+
+    if (store(packet)) {
+        evict();
+    }
+}
+
+bool PacketRing::store(const AVPacket *packet)
+{
+    AVPacket *copy = m_pool.ref(packet);
+    if (!copy) {
+        return false;
+    }
+    bool key = (packet->flags & AV_PKT_FLAG_KEY) && packet->pts != AV_NOPTS_VALUE;
+    if (key) {
+        m_keys.append({ m_firstSeq + m_packets.size(), packet->pts });
+    }
+    m_packets.append(copy);
+    m_cursor = m_packets.size();
+    m_used += copy->size;
+    MemoryBudget::charge(MemoryBudget::SeekBack, copy->size);
+    if (packet->pts != AV_NOPTS_VALUE && (m_lastPts == AV_NOPTS_VALUE || packet->pts > m_lastPts)) {
+        m_lastPts = packet->pts;
+    }
+    return true;
+}
+
+bool PacketRing::rewindTo(int64_t pts)
+{
+    if (m_keys.isEmpty() || pts > m_lastPts) {
+        return false;
+    }
+
+    for (int i = m_keys.size() - 1; i >= 0; i--) {
+        if (m_keys.at(i).pts <= pts) {
+            m_cursor = static_cast<int>(m_keys.at(i).seq - m_firstSeq);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PacketRing::replay(const QList<AVPacket*> &packets)
+{
+    // 不走append：上限和淘汰都不管，整段留到回放完
+    clear();
+    for (const AVPacket *packet : packets) {
+        store(packet);
+    }
+    m_cursor = 0;
+}
+
+bool PacketRing::next(AVPacket *packet)
+{
+    if (m_cursor >= m_packets.size()) {
+        return false;
+    }
+    return av_packet_ref(packet, m_packets.at(m_cursor++)) >= 0;
+}
+
+void PacketRing::evict()
+{
+    // 整组淘汰（从最旧的关键帧到下一个关键帧），至少留下最新的一组；
+    // 回放中不淘汰，回放位置之后的包还要用
+    while (m_keys.size() > 1 && m_cursor == m_packets.size() &&
+           (m_used > m_maxBytes || m_lastPts - m_keys.at(1).pts > m_maxDuration ||
+            MemoryBudget::overBudget())) {
+        dropFront(static_cast<int>(m_keys.at(1).seq - m_firstSeq));
+        m_keys.removeFirst();
+    }
+}
+
+void PacketRing::dropFront(int count)
+{
+    for (int i = 0; i < count; i++) {
+        AVPacket *packet = m_packets.takeFirst();
+        m_used -= packet->size;
+        MemoryBudget::charge(MemoryBudget::SeekBack, -packet->size);
+        m_pool.release(packet);
+    }
+    m_firstSeq += count;
+    m_cursor -= count;
+}
@@ -0,0 +1,60 @@
+#ifndef PACKETRING_H
+#define PACKETRING_H
+
+#include <QList>
+#include "mediapool.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 回看缓冲：顺序读到的视频包（只增加引用，不拷贝数据，包结构体循环复用），保留最近一段，记下每个关键帧的位置。
+// 短距离后退时从缓冲里的关键帧重新送解码器，不用让demuxer跳转读盘；
+// 回放到缓冲末尾后再接着从文件读（文件读位置一直停在缓冲末尾之后）
+class PacketRing
+{
+public:
+    PacketRing();
+    ~PacketRing();
+
+    // 字节和时长（流的时间基）两个上限，任意一个为0时不缓存
+    void setLimits(qint64 bytes, int64_t duration);
+    // demuxer跳转后调用：缓冲里的包和文件读位置不再相连
+    void clear();
+
+    // 从文件顺序读到的包（必须是连续的）
+    void append(const AVPacket *packet);
+
+    // 从pts之前最近的关键帧开始回放，缓冲覆盖不到pts时返回false
+    bool rewindTo(int64_t pts);
+    // 换成另一段连续的包从头回放（循环起点的缓存），调用前demuxer要已经定位到这段之后；
+    // 这段包不受上限限制（关掉回看时也照样回放），回放完后再按上限淘汰
+    void replay(const QList<AVPacket*> &packets);
+    // 回放中取下一个包，已经到缓冲末尾时返回false
+    bool next(AVPacket *packet);
+
+    int size() const { return m_packets.size(); }
+    qint64 memoryUsed() const { return m_used; }
+
+private:
+    struct Key {
+        qint64 seq;         // 包的序号（从clear起累计，不随淘汰变化）
+        int64_t pts;
+    };
+
+    bool store(const AVPacket *packet);
+    void evict();
+    void dropFront(int count);
+
+    PacketPool m_pool;
+    QList<AVPacket*> m_packets;
+    QList<Key> m_keys;                  // 关键帧，按序号递增
+    qint64 m_firstSeq = 0;              // m_packets[0]的序号
+    int m_cursor = 0;                   // 回放位置，等于size()时不在回放
+    int64_t m_lastPts = AV_NOPTS_VALUE; // 缓冲里最大的pts
+    qint64 m_used = 0;
+    qint64 m_maxBytes = 0;
+    int64_t m_maxDuration = 0;
+};
+
+#endif // PACKETRING_H
@@ -0,0 +1,36 @@
+#include "playbackstats.h"
+
+QAtomicInteger<qint64> PlaybackStats::decodedFrames;
+QAtomicInteger<qint64> PlaybackStats::presentedFrames;
+QAtomicInteger<qint64> PlaybackStats::droppedFrames;
+QAtomicInteger<qint64> PlaybackStats::lateFrames;
+QAtomicInteger<qint64> PlaybackStats::audioUnderruns;
+QAtomicInteger<qint64> PlaybackStats::videoBytes;
+QAtomicInteger<qint64> PlaybackStats::convertNs;
+QAtomicInteger<qint64> PlaybackStats::presentNs;
+QAtomicInteger<qint64> PlaybackStats::toneNs;
+QAtomicInt PlaybackStats::frameCacheFrames;
+QAtomicInt PlaybackStats::audioQueueMs;
+QAtomicInteger<qint64> PlaybackStats::avDiffUs;
+QAtomicInteger<qint64> PlaybackStats::positionMs;
+QAtomicInteger<qint64> PlaybackStats::audioClockMs;
+
+PlaybackStats::Snapshot PlaybackStats::snapshot()
+{
+    Snapshot stats;
+    stats.decodedFrames = decodedFrames.loadAcquire();
+    stats.presentedFrames = presentedFrames.loadAcquire();
+    stats.droppedFrames = droppedFrames.loadAcquire();
+    stats.lateFrames = lateFrames.loadAcquire();
+    stats.audioUnderruns = audioUnderruns.loadAcquire();
+    stats.videoBytes = videoBytes.loadAcquire();
+    stats.convertNs = convertNs.loadAcquire();
+    stats.presentNs = presentNs.loadAcquire();
+    stats.toneNs = toneNs.loadAcquire();
+    stats.frameCacheFrames = frameCacheFrames.loadAcquire();
+    stats.audioQueueMs = audioQueueMs.loadAcquire();
+    stats.avDiffUs = avDiffUs.loadAcquire();
+    stats.positionMs = positionMs.loadAcquire();
+    stats.audioClockMs = audioClockMs.loadAcquire();
+    return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef PLAYBACKSTATS_H
+#define PLAYBACKSTATS_H
+
+#include <QAtomicInteger>
+
+// 播放位置和统计：各线程只做原子累加/写入（不加锁，不发信号），
+// 界面按屏幕刷新率读位置，统计面板打开时按固定低频取快照显示
+class PlaybackStats
+{
+public:
+    struct Snapshot {
+        qint64 decodedFrames = 0;
+        qint64 presentedFrames = 0;
+        qint64 droppedFrames = 0;
+        qint64 lateFrames = 0;
+        qint64 audioUnderruns = 0;
+        qint64 videoBytes = 0;
+        qint64 convertNs = 0;
+        qint64 presentNs = 0;
+        qint64 toneNs = 0;
+        int frameCacheFrames = 0;
+        int audioQueueMs = 0;
+        qint64 avDiffUs = 0;
+        qint64 positionMs = 0;
+        qint64 audioClockMs = 0;
+    };
+
+    // 累计值（界面用两次快照的差算速率和平均耗时）
+    static QAtomicInteger<qint64> decodedFrames;    // 视频解码出的帧
+    static QAtomicInteger<qint64> presentedFrames;  // 交给输出后端的帧
+    static QAtomicInteger<qint64> droppedFrames;    // 解出来但没显示（快进追不上、没有时间戳）
+    static QAtomicInteger<qint64> lateFrames;       // 显示时比音频晚一帧以上
+    static QAtomicInteger<qint64> audioUnderruns;   // 音频回调时队列里数据不够
+    static QAtomicInteger<qint64> videoBytes;       // 读到的视频包字节（算码率）
+    static QAtomicInteger<qint64> convertNs;        // 颜色转换/缩放/色调映射耗时
+    static QAtomicInteger<qint64> presentNs;        // 输出后端耗时（纹理上传、拷贝）
+    static QAtomicInteger<qint64> toneNs;           // 其中HDR色调映射的耗时（已算在convertNs里）
+
+    // 当前值
+    static QAtomicInt frameCacheFrames;             // 逐帧缓存里的已解码帧
+    static QAtomicInt audioQueueMs;                 // PCM队列里待播放的时长
+    static QAtomicInteger<qint64> avDiffUs;         // 最近一帧画面减声音（微秒）
+    static QAtomicInteger<qint64> positionMs;       // 最近显示的画面位置
+    static QAtomicInteger<qint64> audioClockMs;     // 音频时钟
+
+    static Snapshot snapshot();
+};
+
+#endif // PLAYBACKSTATS_H
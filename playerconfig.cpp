@@ -0,0 +1,126 @@
+#include "playerconfig.h"
+#include <QDebug>
+
+QString PlayerConfig::videoFilters;
+int PlayerConfig::filterThreads = 0;
+QString PlayerConfig::audioFilters;
+bool PlayerConfig::replayGain = true;
+double PlayerConfig::replayGainTarget = -18.0;
+double PlayerConfig::sceneThreshold = 0.35;
+int PlayerConfig::gopCacheMB = 256;
+int PlayerConfig::reverseCacheMB = 512;
+int PlayerConfig::memoryBudgetMB = 1024;
+int PlayerConfig::seekBackSeconds = 10;
+int PlayerConfig::seekBackMB = 64;
+int PlayerConfig::lowres = 0;
+int PlayerConfig::scaleThreads = 0;
+QString PlayerConfig::yuvKernel = "auto";
+QString PlayerConfig::tonemap = "hable";
+double PlayerConfig::hdrPeakNits = 0;
+QString PlayerConfig::renderBackend = "sdl";
+QString PlayerConfig::audioOutput = "sdl";
+int PlayerConfig::prerollMs = 300;
+bool PlayerConfig::showStats = false;
+bool PlayerConfig::loop = false;
+QString PlayerConfig::benchmark;
+int PlayerConfig::benchIterations = 30;
+QString PlayerConfig::benchCorpus;
+QString PlayerConfig::goldenFile;
+bool PlayerConfig::goldenUpdate = false;
+
+// 支持的参数：
+//   --vf <滤镜链>            视频滤镜
+//   --filter-threads <N>     滤镜线程数
+//   --af <预设名|滤镜链>      音频滤镜
+//   --no-replaygain          关闭自动响度增益
+//   --rg-target <LUFS>       响度目标
+//   --scene-threshold <0~1>  镜头切换阈值
+//   --gop-cache-mb <MB>      逐帧缓存内存预算
+//   --reverse-cache-mb <MB>  倒放缓存内存上限
+//   --memory-mb <MB>         队列和缓存的内存总预算
+//   --seekback-sec <秒>      回看缓冲时长
+//   --seekback-mb <MB>       回看缓冲内存上限
+//   --lowres <0~3|auto>      低分辨率解码
+//   --scale-threads <N>      颜色转换分条数
+//   --yuv-kernel <auto|scalar|off>  手写YUV转换
+//   --tonemap <hable|reinhard|clip|off>  HDR色调映射曲线
+//   --hdr-peak <nit>         HDR峰值亮度
+//   --render <sdl|qt|offscreen>  视频输出后端
+//   --audio-out <sdl|offscreen>  音频输出
+//   --preroll-ms <ms>        开始播放前音频的预读水位
+//   --stats                  启动时显示播放统计
+//   --loop                   循环播放
+//   --bench <名称>           运行基准测试后退出（scale/yuv/yuv-check/golden/avsync/seek）
+//   --bench-iterations <N>   基准测试迭代次数
+//   --bench-corpus <目录|文件>  跳转基准测试用的片段
+//   --golden-file <路径>     黄金帧期望文件
+//   --golden-update          用本次结果更新黄金帧期望文件
+void PlayerConfig::parseArguments(const QStringList &args)
+{
+    for (int i = 1; i < args.size(); i++) {
+        const QString &arg = args.at(i);
+        bool hasValue = (i + 1 < args.size());
+
+        if (arg == "--vf" && hasValue) {
+            videoFilters = args.at(++i);
+        } else if (arg == "--filter-threads" && hasValue) {
+            filterThreads = qMax(0, args.at(++i).toInt());
+        } else if (arg == "--af" && hasValue) {
+            audioFilters = args.at(++i);
+        } else if (arg == "--no-replaygain") {
+            replayGain = false;
+        } else if (arg == "--rg-target" && hasValue) {
+            replayGainTarget = args.at(++i).toDouble();
+        } else if (arg == "--scene-threshold" && hasValue) {
+            sceneThreshold = qBound(0.05, args.at(++i).toDouble(), 1.0);
+        } else if (arg == "--gop-cache-mb" && hasValue) {
+            gopCacheMB = qMax(0, args.at(++i).toInt());
+        } else if (arg == "--reverse-cache-mb" && hasValue) {
+            reverseCacheMB = qMax(16, args.at(++i).toInt());
+        } else if (arg == "--memory-mb" && hasValue) {
+            memoryBudgetMB = qMax(0, args.at(++i).toInt());
+        } else if (arg == "--seekback-sec" && hasValue) {
+            seekBackSeconds = qMax(0, args.at(++i).toInt());
+        } else if (arg == "--seekback-mb" && hasValue) {
+            seekBackMB = qMax(0, args.at(++i).toInt());
+        } else if (arg == "--lowres" && hasValue) {
+            QString value = args.at(++i);
+            lowres = (value == "auto") ? -1 : qBound(0, value.toInt(), 3);
+        } else if (arg == "--scale-threads" && hasValue) {
+            scaleThreads = qMax(0, args.at(++i).toInt());
+        } else if (arg == "--yuv-kernel" && hasValue) {
+            yuvKernel = args.at(++i);
+        } else if (arg == "--tonemap" && hasValue) {
+            tonemap = args.at(++i);
+        } else if (arg == "--hdr-peak" && hasValue) {
+            hdrPeakNits = qMax(0.0, args.at(++i).toDouble());
+        } else if (arg == "--render" && hasValue) {
+            renderBackend = args.at(++i);
+        } else if (arg == "--audio-out" && hasValue) {
+            audioOutput = args.at(++i);
+        } else if (arg == "--preroll-ms" && hasValue) {
+            prerollMs = qBound(0, args.at(++i).toInt(), 5000);
+        } else if (arg == "--stats") {
+            showStats = true;
+        } else if (arg == "--loop") {
+            loop = true;
+        } else if (arg == "--bench" && hasValue) {
+            benchmark = args.at(++i);
+        } else if (arg == "--bench-iterations" && hasValue) {
+            benchIterations = qMax(1, args.at(++i).toInt());
+        } else if (arg == "--bench-corpus" && hasValue) {
+            benchCorpus = args.at(++i);
+        } else if (arg == "--golden-file" && hasValue) {
+            goldenFile = args.at(++i);
+        } else if (arg == "--golden-update") {
+            goldenUpdate = true;
+        }
+    }
+
+    if (!videoFilters.isEmpty()) {
+        qDebug() << "视频滤镜:" << videoFilters << "线程数:" << filterThreads;
+    }
+    if (!audioFilters.isEmpty()) {
+        qDebug() << "音频滤镜:" << audioFilters;
+    }
+}
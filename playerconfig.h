@@ -0,0 +1,67 @@
+#ifndef PLAYERCONFIG_H
+#define PLAYERCONFIG_H
+
+#include <QString>
+#include <QStringList>
+
+// 播放器可调参数（启动参数中读取，线程间只读共享）
+class PlayerConfig {
+public:
+    static void parseArguments(const QStringList &args);
+
+    // 视频滤镜链（libavfilter语法，如 "yadif,crop=1280:720"），为空时不启用滤镜
+    static QString videoFilters;
+    // 滤镜图使用的线程数（0=自动）
+    static int filterThreads;
+    // 音频滤镜（预设名 eq/night/loudnorm 或滤镜链），为空时不启用
+    static QString audioFilters;
+    // 按缓存的响度自动调整增益（ReplayGain方式）
+    static bool replayGain;
+    // 响度目标（LUFS）
+    static double replayGainTarget;
+    // 镜头切换判定阈值（相邻取样帧直方图差异，0~1）
+    static double sceneThreshold;
+    // 逐帧缓存的内存预算（MB）
+    static int gopCacheMB;
+    // 倒放缓存的内存上限（MB）
+    static int reverseCacheMB;
+    // 所有队列和缓存加起来的内存预算（MB，0不限制），超出时缓存淘汰、倒放预取等待
+    static int memoryBudgetMB;
+    // 回看缓冲：保留最近多少秒的视频包（压缩数据），上限多少MB，任一为0关闭
+    static int seekBackSeconds;
+    static int seekBackMB;
+    // 低分辨率解码级别（0关闭，1~3为1/2~1/8，-1按显示区域自动选择；只对支持的解码器有效）
+    static int lowres;
+    // 颜色转换分条数（0按画面大小自动，1不分条）
+    static int scaleThreads;
+    // 不缩放时的手写YUV转换：auto按CPU选AVX2/标量，scalar只用标量，off全部交给swscale
+    static QString yuvKernel;
+    // HDR（PQ/HLG）色调映射曲线：hable/reinhard/clip，off时交给swscale（高光会被截断、发灰）
+    static QString tonemap;
+    // HDR母版峰值亮度（nit），0时取帧附带的元数据，没有则按1000
+    static double hdrPeakNits;
+
+    // 视频输出后端：sdl/qt/offscreen
+    static QString renderBackend;
+    // 音频输出：sdl为声卡，offscreen按实时节奏取数据但不出声
+    static QString audioOutput;
+    // 打开/跳转后音频队列先填到的时长（毫秒），画面解出第一帧、音频到这个水位后才开始走时钟
+    static int prerollMs;
+    // 启动时就显示播放统计（运行中按 I 切换）
+    static bool showStats;
+    // 循环播放整个文件（运行中按 L 切换，A-B循环按 B 设置）
+    static bool loop;
+
+    // 基准测试模式（不打开窗口，跑完退出），如 "scale"、"yuv"
+    static QString benchmark;
+    // 基准测试每项的迭代次数
+    static int benchIterations;
+    // 跳转基准测试的片段目录或文件（为空时用合成片段）
+    static QString benchCorpus;
+    // 黄金帧回归测试的期望文件（为空时用源码目录或程序目录下的golden_frames.txt）
+    static QString goldenFile;
+    // 用本次结果覆盖期望文件
+    static bool goldenUpdate;
+};
+
+#endif // PLAYERCONFIG_H
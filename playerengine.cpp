@@ -0,0 +1,498 @@
+#include "playerengine.h"
+#include "videothread.h"
+#include "audiothread.h"
+#include <QDebug>
+
+QAtomicInt PlayerEngine::s_state(STATE_IDLE);
+
+PlayerEngine::PlayerEngine(VideoThread *video, AudioThread *audio, QObject *parent)
+    : QObject(parent),
+      m_video(video)
+{
+    m_stub.next.storeRelease(nullptr);
+    m_head.storeRelease(&m_stub);
+    m_tail = &m_stub;
+
+    connect(this, &PlayerEngine::openAudio, audio, &AudioThread::init_audio);
+    connect(this, &PlayerEngine::playAudio, audio, &AudioThread::startPlayback);
+    connect(this, &PlayerEngine::pauseAudio, audio, &AudioThread::pausePlayback);
+    connect(this, &PlayerEngine::seekAudio, audio, &AudioThread::seekTo);
+    connect(this, &PlayerEngine::speedAudio, audio, &AudioThread::setSpeed);
+    connect(this, &PlayerEngine::volumeAudio, audio, &AudioThread::setVolume);
+    connect(this, &PlayerEngine::loopAudio, audio, &AudioThread::setLoop);
+    connect(this, &PlayerEngine::filterAudio, audio, &AudioThread::setAudioFilters);
+    connect(audio, &AudioThread::prerolled, this, &PlayerEngine::onAudioPrerolled);
+    // 倒放到头、快进结束都由视频线程发出（和引擎同一个线程，直接调用）
+    connect(video, &VideoThread::reverseFinished, this, &PlayerEngine::onReverseFinished);
+    connect(video, &VideoThread::fastForwardFinished, this, &PlayerEngine::onFastForwardFinished);
+}
+
+PlayerEngine::~PlayerEngine()
+{
+    while (Node *node = pop()) {
+        delete node;
+    }
+}
+
+PlayerState PlayerEngine::state()
+{
+    return static_cast<PlayerState>(s_state.loadAcquire());
+}
+
+void PlayerEngine::publishState(PlayerState state)
+{
+    s_state.storeRelease(state);
+}
+
+void PlayerEngine::post(const PlayerCommand &command)
+{
+    Node *node = new Node;
+    node->command = command;
+    push(node);
+
+    // 只有第一个命令排一次drain，drain开始前攒下的命令一起取走
+    if (m_wakePending.fetchAndStoreOrdered(1) == 0) {
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+    }
+}
+
+void PlayerEngine::open(const QString &path)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Open;
+    command.text = path;
+    post(command);
+}
+
+void PlayerEngine::play()
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Play;
+    post(command);
+}
+
+void PlayerEngine::pause()
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Pause;
+    post(command);
+}
+
+void PlayerEngine::seek(int seekMode, qint64 positionMs)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Seek;
+    command.seekMode = seekMode;
+    command.value = positionMs;
+    post(command);
+}
+
+void PlayerEngine::setSpeed(float speed)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Speed;
+    command.number = speed;
+    post(command);
+}
+
+void PlayerEngine::setVolume(float volume)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Volume;
+    command.number = volume;
+    post(command);
+}
+
+void PlayerEngine::setLoop(qint64 startMs, qint64 endMs)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Loop;
+    command.value = startMs;
+    command.loopEnd = endMs;
+    post(command);
+}
+
+void PlayerEngine::step(int direction)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Step;
+    command.value = direction;
+    post(command);
+}
+
+void PlayerEngine::reverse(float speed)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::Reverse;
+    command.number = speed;
+    post(command);
+}
+
+void PlayerEngine::setAudioFilters(const QString &filters)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::AudioFilter;
+    command.text = filters;
+    post(command);
+}
+
+void PlayerEngine::setVideoFilters(const QString &filters)
+{
+    PlayerCommand command;
+    command.type = PlayerCommand::VideoFilter;
+    command.text = filters;
+    post(command);
+}
+
+void PlayerEngine::push(Node *node)
+{
+    node->next.storeRelease(nullptr);
+    Node *prev = m_head.fetchAndStoreOrdered(node);
+    // 从这里到下一行之间消费者看到的链是断的，pop会返回空，生产者随后排drain
+    prev->next.storeRelease(node);
+}
+
+PlayerEngine::Node* PlayerEngine::pop()
+{
+    Node *tail = m_tail;
+    Node *next = tail->next.loadAcquire();
+    if (tail == &m_stub) {
+        if (!next) {
+            return nullptr;
+        }
+        m_tail = next;
+        tail = next;
+        next = next->next.loadAcquire();
+    }
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+
+    // tail是最后一个节点：把stub接到后面，才能把tail取走
+    if (tail != m_head.loadAcquire()) {
+        return nullptr;
+    }
+    push(&m_stub);
+    next = tail->next.loadAcquire();
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void PlayerEngine::drain()
+{
+    m_wakePending.storeRelease(0);
+
+    PlayerCommand open;
+    PlayerCommand playPause;
+    PlayerCommand seek;
+    PlayerCommand speed;
+    PlayerCommand volume;
+    PlayerCommand loop;
+    PlayerCommand reverse;
+    PlayerCommand audioFilter;
+    PlayerCommand videoFilter;
+    int stepCount = 0;
+    bool hasOpen = false;
+    bool hasPlayPause = false;
+    bool hasSeek = false;
+    bool seekHeld = false;
+    bool hasSpeed = false;
+    bool hasVolume = false;
+    bool hasLoop = false;
+    bool hasReverse = false;
+    bool hasStep = false;
+    bool hasAudioFilter = false;
+    bool hasVideoFilter = false;
+    int count = 0;
+
+    while (Node *node = pop()) {
+        const PlayerCommand &command = node->command;
+        count++;
+        switch (command.type) {
+        case PlayerCommand::Open:
+            // 之前对旧文件的播放/暂停/跳转没有意义了，倍速、音量和滤镜保留
+            open = command;
+            hasOpen = true;
+            hasPlayPause = false;
+            hasSeek = false;
+            seekHeld = false;
+            hasReverse = false;
+            hasStep = false;
+            stepCount = 0;
+            break;
+        case PlayerCommand::Play:
+        case PlayerCommand::Pause:
+            playPause = command;
+            hasPlayPause = true;
+            break;
+        case PlayerCommand::Seek:
+            seekHeld = seekHeld || command.seekMode == PlayerCommand::SeekHold;
+            seek = command;
+            hasSeek = true;
+            break;
+        case PlayerCommand::Speed:
+            speed = command;
+            hasSpeed = true;
+            break;
+        case PlayerCommand::Volume:
+            volume = command;
+            hasVolume = true;
+            break;
+        case PlayerCommand::Loop:
+            loop = command;
+            hasLoop = true;
+            break;
+        case PlayerCommand::Step:
+            // 逐帧会先暂停，之前的播放/暂停不用再执行
+            stepCount += static_cast<int>(command.value);
+            hasStep = true;
+            hasPlayPause = false;
+            break;
+        case PlayerCommand::Reverse:
+            // 开始倒放时之前的逐帧和播放/暂停都作废
+            if (command.number > 0) {
+                hasStep = false;
+                stepCount = 0;
+                hasPlayPause = false;
+            }
+            reverse = command;
+            hasReverse = true;
+            break;
+        case PlayerCommand::AudioFilter:
+            audioFilter = command;
+            hasAudioFilter = true;
+            break;
+        case PlayerCommand::VideoFilter:
+            videoFilter = command;
+            hasVideoFilter = true;
+            break;
+        }
+        delete node;
+    }
+
+    if (count > 1) {
+        qDebug() << "合并了" << count << "条播放命令";
+    }
+
+    // 先换文件，再改倍速音量和循环区间，跳到位置后倒放/逐帧，最后决定播还是停
+    if (hasOpen) {
+        // 视频在这里同步解出第一帧，音频填好后通知回来
+        m_video->init_video(open.text);
+        m_waitAudio = true;
+        m_startAfterPreroll = true;
+        emit openAudio(open.text);
+    }
+    if (hasSpeed) {
+        m_video->setPlaybackSpeed(speed.number);
+        emit speedAudio(speed.number);
+    }
+    if (hasVolume) {
+        emit volumeAudio(volume.number);
+    }
+    if (hasAudioFilter) {
+        emit filterAudio(audioFilter.text);
+    }
+    if (hasVideoFilter) {
+        m_video->setVideoFilters(videoFilter.text);
+    }
+    if (hasLoop) {
+        // 两边各自在终点跳回起点：视频从缓存的包里重新解，音频提前解好接在队列后面
+        m_video->setLoop(loop.value, loop.loopEnd);
+        emit loopAudio(loop.value, loop.loopEnd);
+    }
+    if (hasSeek) {
+        applySeek(seek, seekHeld);
+    }
+    if (hasReverse) {
+        applyReverse(reverse.number);
+    }
+    if (hasStep) {
+        applyStep(stepCount);
+    }
+    if (hasPlayPause) {
+        if (playPause.type == PlayerCommand::Play) {
+            applyPlay();
+        } else {
+            applyPause();
+        }
+    }
+}
+
+void PlayerEngine::applyPlay()
+{
+    switch (state()) {
+    case STATE_IDLE:
+        // 还没打开文件
+        break;
+
+    case STATE_READY:
+        m_startAfterPreroll = true;
+        if (!m_waitAudio) {
+            startTogether();
+        }
+        break;
+
+    case STATE_PLAYING:
+        break;
+
+    case STATE_REVERSING:
+    case STATE_PAUSED:
+        // 倒放中按播放：先停倒放，再和暂停一样继续
+        applyReverse(0);
+        publishState(STATE_PLAYING);
+        // 音频还在跳转时画面等它填好（onAudioPrerolled里继续），播放命令排在跳转之后
+        if (!m_waitAudio) {
+            m_video->resumePlayback();
+        }
+        emit playAudio();
+        break;
+
+    case STATE_ENDED:
+        // 播放结束，两边都回到开头预读后再来
+        m_video->prerollVideo();
+        m_waitAudio = true;
+        m_startAfterPreroll = true;
+        emit seekAudio(0);
+        break;
+    }
+}
+
+void PlayerEngine::applyPause()
+{
+    if (state() == STATE_READY) {
+        // 还在预读：取消预读完的自动开始
+        m_startAfterPreroll = false;
+        return;
+    }
+    if (state() != STATE_PLAYING) {
+        return;
+    }
+    publishState(STATE_PAUSED);
+    m_video->pausePlayback();
+    emit pauseAudio();
+}
+
+void PlayerEngine::applySeek(const PlayerCommand &seek, bool held)
+{
+    // 按下和拖动被合并到一起时，按下的"停住画面"不能丢
+    if (held && seek.seekMode == PlayerCommand::SeekScrub) {
+        m_video->setSeekSlider(PlayerCommand::SeekHold, 0);
+    }
+    if (seek.seekMode != PlayerCommand::SeekCommit) {
+        m_video->setSeekSlider(seek.seekMode, static_cast<int>(seek.value));
+        return;
+    }
+
+    // 松开：画面定位到目标帧（已显示），等音频重新填到水位后再一起走
+    m_video->setSeekSlider(PlayerCommand::SeekScrub, static_cast<int>(seek.value));
+    m_waitAudio = true;
+    emit seekAudio(seek.value);
+}
+
+void PlayerEngine::applyReverse(float speed)
+{
+    PlayerState current = state();
+    if (current == STATE_IDLE || current == STATE_READY) {
+        return;
+    }
+
+    if (speed <= 0) {
+        if (current != STATE_REVERSING) {
+            return;
+        }
+        m_video->setReversePlayback(0);
+        publishState(STATE_PAUSED);
+        resyncAudio();
+        return;
+    }
+
+    // 倒放时音频停着；启动失败时视频线程会发reverseFinished，所以先发布状态
+    if (current == STATE_PLAYING) {
+        m_video->pausePlayback();
+        emit pauseAudio();
+    }
+    publishState(STATE_REVERSING);
+    m_video->setReversePlayback(speed);
+}
+
+void PlayerEngine::applyStep(int count)
+{
+    PlayerState current = state();
+    if (current == STATE_IDLE || current == STATE_READY || count == 0) {
+        return;
+    }
+
+    // 逐帧时先暂停（倒放中先停倒放）
+    if (current == STATE_REVERSING) {
+        m_video->setReversePlayback(0);
+    } else if (current == STATE_PLAYING) {
+        m_video->pausePlayback();
+        emit pauseAudio();
+    }
+
+    int direction = (count < 0) ? -1 : 1;
+    for (int i = 0; i < qAbs(count); i++) {
+        m_video->stepFrame(direction);
+    }
+
+    // 播放结束后逐帧也进入暂停：继续播放从这一帧接着走，不从头开始；
+    // 音频只在这批逐帧做完后跟一次
+    publishState(STATE_PAUSED);
+    resyncAudio();
+}
+
+void PlayerEngine::onReverseFinished()
+{
+    // 倒放到了开头（或没能启动），画面停在那里
+    if (state() == STATE_REVERSING) {
+        publishState(STATE_PAUSED);
+        resyncAudio();
+    }
+}
+
+void PlayerEngine::resyncAudio()
+{
+    // 画面自己走到了别处（倒放、逐帧），音频还停在原来的位置：按跳转提交同样处理，
+    // 跳到画面当前位置，填好之前继续播放也要等它
+    double position = m_video->currentPosition();
+    if (position < 0) {
+        return;
+    }
+    m_waitAudio = true;
+    emit seekAudio(static_cast<qint64>(position * 1000));
+}
+
+void PlayerEngine::onFastForwardFinished(qint64 positionMs)
+{
+    // 快进时音频静音没走，画面重新定位后音频按跳转提交同样处理：填好之前不算预读完
+    m_waitAudio = true;
+    emit seekAudio(positionMs);
+}
+
+void PlayerEngine::onAudioPrerolled()
+{
+    if (!m_waitAudio) {
+        return;
+    }
+    m_waitAudio = false;
+
+    if (state() == STATE_READY) {
+        if (m_startAfterPreroll) {
+            startTogether();
+        }
+    } else if (state() == STATE_PLAYING) {
+        m_video->resumePlayback();
+    }
+}
+
+void PlayerEngine::startTogether()
+{
+    m_startAfterPreroll = false;
+    // 音频是主时钟，两边同时从预读好的位置开始
+    emit playAudio();
+    m_video->startPlayback();
+}
@@ -0,0 +1,120 @@
+#ifndef PLAYERENGINE_H
+#define PLAYERENGINE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QString>
+#include "global_status.h"
+
+class VideoThread;
+class AudioThread;
+
+// 播放控制命令（界面等任意线程投递，引擎线程统一执行）
+struct PlayerCommand {
+    enum Type {
+        Open,       // 打开文件（text为路径）
+        Play,
+        Pause,
+        Seek,       // value为毫秒，seekMode同setSeekSlider的flog
+        Speed,      // number为倍速
+        Volume,     // number为音量（0~3）
+        Loop,       // value为起点毫秒（-1关闭），loopEnd为终点毫秒（-1到文件末尾）
+        Step,       // value为逐帧方向（1下一帧，-1上一帧），合并时累加
+        Reverse,    // number为倒放倍速（<=0停止倒放）
+        AudioFilter,    // text为音频滤镜（预设名或滤镜链，空字符串关闭）
+        VideoFilter     // text为视频滤镜链（空字符串关闭）
+    };
+    // 拖动进度条的三个阶段
+    enum SeekMode {
+        SeekHold = 0,       // 按下：先停住画面
+        SeekScrub = 1,      // 拖动中：只跳视频
+        SeekCommit = 2      // 松开：跳转后继续播放，音频跟着跳
+    };
+
+    Type type = Play;
+    QString text;
+    qint64 value = 0;
+    int seekMode = SeekCommit;
+    float number = 0;
+    qint64 loopEnd = -1;
+};
+
+// 播放引擎：持有播放状态，和视频线程在同一个线程里运行。
+// 命令进无锁多生产者单消费者队列，引擎一次取完后合并（同类命令新的覆盖旧的，
+// 打开文件会作废之前的播放/暂停/跳转），再依次执行；状态只由引擎线程写，原子发布。
+// 打开和跳转后先预读：画面解出第一帧，音频队列填到水位，两边都好了才开始走时钟
+class PlayerEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    PlayerEngine(VideoThread *video, AudioThread *audio, QObject *parent = nullptr);
+    ~PlayerEngine();
+
+    // 任意线程调用
+    void post(const PlayerCommand &command);
+    void open(const QString &path);
+    void play();
+    void pause();
+    void seek(int seekMode, qint64 positionMs);
+    void setSpeed(float speed);
+    void setVolume(float volume);
+    void setLoop(qint64 startMs, qint64 endMs);
+    void step(int direction);
+    void reverse(float speed);
+    void setAudioFilters(const QString &filters);
+    void setVideoFilters(const QString &filters);
+
+    // 当前状态（任意线程读）
+    static PlayerState state();
+    // 只在引擎线程（视频线程）调用
+    static void publishState(PlayerState state);
+
+signals:
+    // 音频线程的对应槽（排队执行）
+    void openAudio(QString path);
+    void playAudio();
+    void pauseAudio();
+    void seekAudio(qint64 positionMs);
+    void speedAudio(float speed);
+    void volumeAudio(float volume);
+    void loopAudio(qint64 startMs, qint64 endMs);
+    void filterAudio(QString filters);
+
+private slots:
+    void drain();
+    void onAudioPrerolled();
+    void onReverseFinished();
+    void onFastForwardFinished(qint64 positionMs);
+
+private:
+    struct Node {
+        QAtomicPointer<Node> next;
+        PlayerCommand command;
+    };
+
+    void push(Node *node);
+    Node* pop();
+    void applyPlay();
+    void applyPause();
+    void applySeek(const PlayerCommand &seek, bool held);
+    void applyReverse(float speed);
+    void applyStep(int count);
+    void resyncAudio();
+    void startTogether();
+
+    VideoThread *m_video = nullptr;
+    bool m_waitAudio = false;           // 音频还在预读
+    bool m_startAfterPreroll = false;   // 预读完自动开始（打开文件、结束后重播）
+
+    // Vyukov式侵入队列：生产者只交换m_head，消费者独占m_tail
+    QAtomicPointer<Node> m_head;
+    Node *m_tail = nullptr;
+    Node m_stub;
+    QAtomicInt m_wakePending;           // 已经排了一次drain，不再重复排
+
+    static QAtomicInt s_state;
+};
+
+#endif // PLAYERENGINE_H
@@ -0,0 +1,66 @@
+#include "qtrenderbackend.h"
+#include <QDebug>
+#include <QEvent>
+#include <QPainter>
+#include <QWidget>
+
+QtRenderBackend::QtRenderBackend(QWidget *widget)
+    : m_widget(widget)
+{
+    widget->installEventFilter(this);
+    // 整个区域都由我们画，省掉背景擦除
+    widget->setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+QtRenderBackend::~QtRenderBackend()
+{
+    if (m_widget) {
+        m_widget->removeEventFilter(this);
+    }
+}
+
+bool QtRenderBackend::open()
+{
+    qDebug() << "使用QPainter输出";
+    return !m_widget.isNull();
+}
+
+void QtRenderBackend::close()
+{
+    QMutexLocker locker(&m_mutex);
+    m_image = QImage();
+}
+
+bool QtRenderBackend::present(const uint8_t *data, int linesize, int width, int height, double displayAspect)
+{
+    if (!m_widget) {
+        return false;
+    }
+
+    {
+        // 转换缓冲下一帧就会被覆盖，这里必须深拷贝
+        QImage image(data, width, height, linesize, QImage::Format_RGB888);
+        QMutexLocker locker(&m_mutex);
+        m_image = image.copy();
+        m_displayAspect = displayAspect;
+    }
+    QMetaObject::invokeMethod(m_widget.data(), "update", Qt::QueuedConnection);
+    return true;
+}
+
+bool QtRenderBackend::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != m_widget || event->type() != QEvent::Paint) {
+        return QObject::eventFilter(watched, event);
+    }
+
+    QPainter painter(m_widget.data());
+    painter.fillRect(m_widget->rect(), Qt::black);
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_image.isNull()) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(letterbox(m_widget->width(), m_widget->height(), m_displayAspect), m_image);
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef QTRENDERBACKEND_H
+#define QTRENDERBACKEND_H
+
+#include "renderbackend.h"
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QPointer>
+
+class QWidget;
+
+// 用QPainter画到Qt部件上：视频线程交来的画面先拷成QImage，
+// 再请求界面线程重画；不依赖SDL，适合没有原生窗口句柄的平台
+// 必须在界面线程中创建（要在部件上安装事件过滤器）
+class QtRenderBackend : public QObject, public RenderBackend
+{
+    Q_OBJECT
+public:
+    explicit QtRenderBackend(QWidget *widget);
+    ~QtRenderBackend() override;
+
+    const char *name() const override { return "qt"; }
+    bool open() override;
+    void close() override;
+    bool present(const uint8_t *data, int linesize, int width, int height, double displayAspect) override;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QPointer<QWidget> m_widget;
+    QMutex m_mutex;                 // 保护下面两项（视频线程写，界面线程读）
+    QImage m_image;
+    double m_displayAspect = 0;
+};
+
+#endif // QTRENDERBACKEND_H
@@ -0,0 +1,44 @@
+#include "renderbackend.h"
+#include "sdlrenderbackend.h"
+#include "qtrenderbackend.h"
+#include "offscreenrenderbackend.h"
+#include <QDebug>
+#include <QWidget>
+
+RenderBackend *RenderBackend::create(const QString &name, QWidget *widget)
+{
+    if (name == "offscreen") {
+        return new OffscreenRenderBackend;
+    }
+
+    if (!widget) {
+        qDebug() << "错误：" << name << "输出需要显示窗口";
+        return nullptr;
+    }
+    if (name == "sdl") {
+        return new SdlRenderBackend(widget->winId());
+    }
+    if (name == "qt") {
+        return new QtRenderBackend(widget);
+    }
+
+    qDebug() << "未知的输出后端:" << name << "（可选：sdl、qt、offscreen）";
+    return nullptr;
+}
+
+QRect RenderBackend::letterbox(int outWidth, int outHeight, double displayAspect)
+{
+    QRect rect(0, 0, outWidth, outHeight);
+    if (outWidth <= 0 || outHeight <= 0 || displayAspect <= 0) {
+        return rect;
+    }
+
+    if (outWidth / (double)outHeight > displayAspect) {
+        int width = static_cast<int>(outHeight * displayAspect);
+        rect.setRect((outWidth - width) / 2, 0, width, outHeight);
+    } else {
+        int height = static_cast<int>(outWidth / displayAspect);
+        rect.setRect(0, (outHeight - height) / 2, outWidth, height);
+    }
+    return rect;
+}
@@ -0,0 +1,30 @@
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include <QString>
+#include <QRect>
+
+class QWidget;
+
+// 视频输出后端：接收转换好的RGB24画面，显示到窗口或留在内存里
+// 可选：sdl（嵌入Qt部件的SDL渲染器）、qt（QImage + QPainter）、offscreen（只算校验值，不需要窗口）
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {}
+
+    virtual const char *name() const = 0;
+    // 每个文件开始播放时打开输出
+    virtual bool open() = 0;
+    // 释放纹理、渲染器等，之后可以再次open
+    virtual void close() = 0;
+    // 输出一帧RGB24；displayAspect为显示宽高比（已计入SAR），用于留黑边
+    virtual bool present(const uint8_t *data, int linesize, int width, int height, double displayAspect) = 0;
+
+    // 按名称创建后端，名称未知或需要窗口却没有时返回nullptr
+    static RenderBackend *create(const QString &name, QWidget *widget);
+    // 输出区域内按宽高比居中的矩形
+    static QRect letterbox(int outWidth, int outHeight, double displayAspect);
+};
+
+#endif // RENDERBACKEND_H
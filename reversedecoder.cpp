@@ -0,0 +1,269 @@
+#include "reversedecoder.h"
+#include "gopcache.h"
+#include "memorybudget.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+ReverseDecoder::ReverseDecoder()
+{
+    // 段与段之间有先后依赖，一个生产线程就够；解码器自身再开帧级多线程
+    m_pool.setMaxThreadCount(1);
+}
+
+ReverseDecoder::~ReverseDecoder()
+{
+    stop();
+}
+
+AVRational ReverseDecoder::timeBase() const
+{
+    if (!m_formatCtx) {
+        return AVRational{1, AV_TIME_BASE};
+    }
+    return m_formatCtx->streams[m_streamIndex]->time_base;
+}
+
+bool ReverseDecoder::start(const QString &filePath, int streamIndex, int64_t fromPts, qint64 memoryCap)
+{
+    stop();
+
+    if (avformat_open_input(&m_formatCtx, filePath.toUtf8().constData(), nullptr, nullptr) < 0) {
+        qDebug() << "倒放：无法打开文件";
+        return false;
+    }
+    if (avformat_find_stream_info(m_formatCtx, nullptr) < 0 ||
+            streamIndex < 0 || streamIndex >= (int)m_formatCtx->nb_streams) {
+        stop();
+        return false;
+    }
+    for (unsigned int i = 0; i < m_formatCtx->nb_streams; i++) {
+        if ((int)i != streamIndex) {
+            m_formatCtx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    AVStream *stream = m_formatCtx->streams[streamIndex];
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    m_codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!m_codecCtx || avcodec_parameters_to_context(m_codecCtx, stream->codecpar) < 0) {
+        stop();
+        return false;
+    }
+    m_codecCtx->thread_count = 0;
+    if (avcodec_open2(m_codecCtx, codec, nullptr) < 0) {
+        stop();
+        return false;
+    }
+
+    m_packet = av_packet_alloc();
+    m_frame = av_frame_alloc();
+    if (!m_packet || !m_frame) {
+        stop();
+        return false;
+    }
+
+    m_streamIndex = streamIndex;
+    m_streamStart = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+    m_memoryCap = qMax<qint64>(memoryCap, 16 * 1024 * 1024);
+    m_stopRequested.storeRelease(0);
+    m_producerDone = false;
+    m_bufferedBytes = 0;
+
+    m_producer = QtConcurrent::run(&m_pool, [this, fromPts]() { produce(fromPts); });
+    qDebug() << "倒放开始，内存上限" << m_memoryCap / (1024 * 1024) << "MB";
+    return true;
+}
+
+void ReverseDecoder::stop()
+{
+    if (m_producer.isRunning()) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopRequested.storeRelease(1);
+            m_spaceAvailable.wakeAll();
+        }
+        m_producer.waitForFinished();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_segments.isEmpty()) {
+        freeSegment(m_segments.dequeue());
+    }
+    freeSegment(m_current);
+    m_current = nullptr;
+    m_currentIndex = -1;
+    MemoryBudget::charge(MemoryBudget::ReverseCache, -m_bufferedBytes);
+    m_bufferedBytes = 0;
+
+    av_frame_free(&m_frame);
+    av_packet_free(&m_packet);
+    avcodec_free_context(&m_codecCtx);
+    avformat_close_input(&m_formatCtx);
+}
+
+AVFrame *ReverseDecoder::takeFrame(bool *finished)
+{
+    QMutexLocker locker(&m_mutex);
+    *finished = false;
+
+    while (true) {
+        if (m_current && m_currentIndex >= 0) {
+            AVFrame *frame = m_current->frames[m_currentIndex];
+            m_current->frames[m_currentIndex--] = nullptr;
+
+            qint64 bytes = GopCache::frameBytes(frame);
+            m_current->bytes -= bytes;
+            m_bufferedBytes -= bytes;
+            MemoryBudget::charge(MemoryBudget::ReverseCache, -bytes);
+            m_spaceAvailable.wakeOne();
+            return frame;
+        }
+
+        freeSegment(m_current);
+        m_current = nullptr;
+        if (m_segments.isEmpty()) {
+            *finished = m_producerDone;
+            return nullptr;
+        }
+        m_current = m_segments.dequeue();
+        m_currentIndex = m_current->frames.size() - 1;
+    }
+}
+
+qint64 ReverseDecoder::bufferedBytes()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bufferedBytes;
+}
+
+void ReverseDecoder::produce(int64_t endPts)
+{
+    // 每段最多占一半内存，正在倒放的一段和预取的一段同时放得下；
+    // 超出总预算时手上的帧倒放完才预取下一段
+    qint64 window = m_memoryCap / 2;
+
+    while (endPts > m_streamStart) {
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopRequested.loadAcquire() &&
+                   (m_bufferedBytes + window > m_memoryCap ||
+                    (m_bufferedBytes > 0 && MemoryBudget::overBudget()))) {
+                m_spaceAvailable.wait(&m_mutex);
+            }
+        }
+        if (m_stopRequested.loadAcquire()) {
+            break;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        ReverseSegment *segment = new ReverseSegment;
+        if (!decodeSegment(endPts, segment) || segment->frames.isEmpty()) {
+            freeSegment(segment);
+            break;
+        }
+        endPts = segment->startPts;
+
+        qDebug() << "倒放预取一段：" << segment->frames.size() << "帧，"
+                 << segment->bytes / (1024 * 1024) << "MB，用时" << timer.elapsed() << "ms";
+
+        QMutexLocker locker(&m_mutex);
+        m_segments.enqueue(segment);
+        m_bufferedBytes += segment->bytes;
+        MemoryBudget::charge(MemoryBudget::ReverseCache, segment->bytes);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_producerDone = true;
+}
+
+// 从endPts之前最近的关键帧正向解码到endPts，只保留最后window大小的帧；
+// GOP比窗口长时，前面剩下的部分由下一段重新从关键帧解码
+bool ReverseDecoder::decodeSegment(int64_t endPts, ReverseSegment *segment)
+{
+    AVStream *stream = m_formatCtx->streams[m_streamIndex];
+    qint64 window = m_memoryCap / 2;
+    int64_t seekPts = endPts - 1;
+    int64_t oneSecond = av_rescale_q(AV_TIME_BASE, AV_TIME_BASE_Q, stream->time_base);
+
+    // 有的格式跳转不精确，落点在endPts之后时往前多退一些再试
+    for (int attempt = 0; attempt < 4 && segment->frames.isEmpty(); attempt++) {
+        if (av_seek_frame(m_formatCtx, m_streamIndex, seekPts, AVSEEK_FLAG_BACKWARD) < 0) {
+            return false;
+        }
+        avcodec_flush_buffers(m_codecCtx);
+
+        bool done = false;
+        bool draining = false;
+        while (!done) {
+            if (m_stopRequested.loadAcquire()) {
+                return false;
+            }
+
+            int ret = avcodec_receive_frame(m_codecCtx, m_frame);
+            if (ret >= 0) {
+                int64_t pts = (m_frame->best_effort_timestamp != AV_NOPTS_VALUE)
+                        ? m_frame->best_effort_timestamp : m_frame->pts;
+                if (pts == AV_NOPTS_VALUE) {
+                    av_frame_unref(m_frame);
+                    continue;
+                }
+                if (pts >= endPts) {
+                    av_frame_unref(m_frame);
+                    done = true;
+                    break;
+                }
+
+                AVFrame *frame = av_frame_alloc();
+                av_frame_move_ref(frame, m_frame);
+                frame->pts = pts;
+                segment->frames.append(frame);
+                segment->bytes += GopCache::frameBytes(frame);
+
+                while (segment->bytes > window && segment->frames.size() > 1) {
+                    AVFrame *oldest = segment->frames.takeFirst();
+                    segment->bytes -= GopCache::frameBytes(oldest);
+                    av_frame_free(&oldest);
+                }
+                continue;
+            }
+            if (ret == AVERROR_EOF || draining) {
+                break;
+            }
+
+            ret = av_read_frame(m_formatCtx, m_packet);
+            if (ret < 0) {
+                avcodec_send_packet(m_codecCtx, nullptr);
+                draining = true;
+                continue;
+            }
+            if (m_packet->stream_index == m_streamIndex) {
+                avcodec_send_packet(m_codecCtx, m_packet);
+            }
+            av_packet_unref(m_packet);
+        }
+
+        seekPts -= oneSecond;
+        if (seekPts < m_streamStart - oneSecond) {
+            break;
+        }
+    }
+
+    if (segment->frames.isEmpty()) {
+        return false;
+    }
+    segment->startPts = segment->frames.first()->pts;
+    return true;
+}
+
+void ReverseDecoder::freeSegment(ReverseSegment *segment)
+{
+    if (!segment) {
+        return;
+    }
+    for (AVFrame *frame : segment->frames) {
+        av_frame_free(&frame);
+    }
+    delete segment;
+}
@@ -0,0 +1,70 @@
+#ifndef REVERSEDECODER_H
+#define REVERSEDECODER_H
+
+#include <QString>
+#include <QVector>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QThreadPool>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+// 一段正向解码好的帧（pts升序），倒放时从后往前取
+struct ReverseSegment {
+    QVector<AVFrame*> frames;
+    int64_t startPts = AV_NOPTS_VALUE;  // 第一帧的pts，也是前一段的结束位置
+    qint64 bytes = 0;
+};
+
+// 倒放调度：工作线程用独立的解复用器/解码器，从后往前一段一段解码（每段从关键帧开始），
+// 当前段在倒着显示时继续预取前面的段，缓存的帧总量不超过内存上限
+class ReverseDecoder
+{
+public:
+    ReverseDecoder();
+    ~ReverseDecoder();
+
+    // 从fromPts之前的一帧开始倒放（pts使用流的时间基）
+    bool start(const QString &filePath, int streamIndex, int64_t fromPts, qint64 memoryCap);
+    void stop();
+
+    bool isActive() const { return m_formatCtx != nullptr; }
+    AVRational timeBase() const;
+
+    // 按倒序取下一帧（调用者释放），还没解码出来时返回nullptr；到开头后finished为true
+    AVFrame *takeFrame(bool *finished);
+    qint64 bufferedBytes();
+
+private:
+    void produce(int64_t fromPts);
+    bool decodeSegment(int64_t endPts, ReverseSegment *segment);
+    static void freeSegment(ReverseSegment *segment);
+
+    AVFormatContext *m_formatCtx = nullptr;
+    AVCodecContext *m_codecCtx = nullptr;
+    AVPacket *m_packet = nullptr;
+    AVFrame *m_frame = nullptr;
+    int m_streamIndex = -1;
+    int64_t m_streamStart = 0;
+    qint64 m_memoryCap = 0;
+
+    QThreadPool m_pool;
+    QFuture<void> m_producer;
+    QAtomicInt m_stopRequested;
+
+    QMutex m_mutex;
+    QWaitCondition m_spaceAvailable;            // 消费者取走帧后唤醒生产者
+    QQueue<ReverseSegment*> m_segments;         // 已解码、等待倒放的段
+    ReverseSegment *m_current = nullptr;        // 正在倒放的段
+    int m_currentIndex = -1;
+    qint64 m_bufferedBytes = 0;
+    bool m_producerDone = false;
+};
+
+#endif // REVERSEDECODER_H
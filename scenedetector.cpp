@@ -0,0 +1,340 @@
+#include "scenedetector.h"
+#include "playerconfig.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+#include <libavutil/imgutils.h>
+}
+
+// 取样间隔（秒）和缩略图尺寸，够判断镜头切换就行
+static const double SCENE_SAMPLE_INTERVAL = 0.2;
+static const int SCENE_THUMB_WIDTH = 64;
+static const int SCENE_THUMB_HEIGHT = 36;
+static const int SCENE_HIST_BINS = 32;
+// 两个切换点之间最短间隔，闪光之类的不算新镜头
+static const double SCENE_MIN_LENGTH = 1.0;
+// 跳转时忽略离当前位置太近的边界，连按上一个时能继续往前走
+static const double SCENE_JUMP_MARGIN = 1.0;
+
+SceneDetector::SceneDetector(QObject *parent) : QObject(parent)
+{
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+SceneDetector::~SceneDetector()
+{
+    // 不能clear()：被删掉的段的future永远不会完成，调度任务会一直等
+    m_cancelled.storeRelease(1);
+    for (QFuture<void> &driver : m_drivers) {
+        driver.waitForFinished();
+    }
+    m_pool.waitForDone();
+}
+
+void SceneDetector::detect(const QString &filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_indexes.contains(filePath) || m_detecting == filePath) {
+            return;
+        }
+        m_detecting = filePath;
+    }
+
+    // 已经结束的调度任务不用再记着
+    for (int i = m_drivers.size() - 1; i >= 0; i--) {
+        if (m_drivers.at(i).isFinished()) {
+            m_drivers.removeAt(i);
+        }
+    }
+
+    QThreadPool *pool = &m_pool;
+    m_drivers.append(QtConcurrent::run([this, pool, filePath]() {
+        SceneIndex index;
+        double duration = 0;
+        if (!readChapters(filePath, &duration, &index.chapters)) {
+            QMutexLocker locker(&m_mutex);
+            // 期间可能已经开始检测别的文件，那个标记不是这里的
+            if (m_detecting == filePath) {
+                m_detecting.clear();
+            }
+            return;
+        }
+
+        // 章节先放进去，检测完成前也能按章节跳
+        {
+            QMutexLocker locker(&m_mutex);
+            m_indexes.insert(filePath, index);
+        }
+
+        index.cuts = computeCuts(pool, &m_cancelled, filePath, duration);
+        if (m_cancelled.loadAcquire()) {
+            return;
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_indexes.insert(filePath, index);
+            if (m_detecting == filePath) {
+                m_detecting.clear();
+            }
+        }
+        emit sceneIndexReady(filePath, index.cuts.size());
+    }));
+}
+
+bool SceneDetector::nextBoundary(const QString &filePath, double seconds, double *target)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_indexes.constFind(filePath);
+    if (it == m_indexes.constEnd()) {
+        return false;
+    }
+
+    const QVector<double> &bounds = it.value().boundaries();
+    auto next = std::upper_bound(bounds.constBegin(), bounds.constEnd(), seconds + SCENE_JUMP_MARGIN / 2);
+    if (next == bounds.constEnd()) {
+        return false;
+    }
+    *target = *next;
+    return true;
+}
+
+bool SceneDetector::previousBoundary(const QString &filePath, double seconds, double *target)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_indexes.constFind(filePath);
+    if (it == m_indexes.constEnd()) {
+        return false;
+    }
+
+    const QVector<double> &bounds = it.value().boundaries();
+    if (bounds.isEmpty()) {
+        return false;
+    }
+    auto prev = std::lower_bound(bounds.constBegin(), bounds.constEnd(), seconds - SCENE_JUMP_MARGIN);
+    // 前面没有边界了就回到开头
+    *target = (prev == bounds.constBegin()) ? 0.0 : *(prev - 1);
+    return true;
+}
+
+bool SceneDetector::readChapters(const QString &filePath, double *duration, QVector<double> *chapters)
+{
+    AVFormatContext *formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, filePath.toUtf8().constData(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+
+    *duration = (formatCtx->duration > 0) ? formatCtx->duration / (double)AV_TIME_BASE : 0.0;
+    for (unsigned int i = 0; i < formatCtx->nb_chapters; i++) {
+        AVChapter *chapter = formatCtx->chapters[i];
+        double start = chapter->start * av_q2d(chapter->time_base);
+        if (start > 0) {
+            chapters->append(start);
+        }
+    }
+    std::sort(chapters->begin(), chapters->end());
+
+    avformat_close_input(&formatCtx);
+    return *duration > 0;
+}
+
+QVector<double> SceneDetector::computeCuts(QThreadPool *pool, const QAtomicInt *cancelled,
+                                           const QString &filePath, double duration)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 视频解码比音频重，每个线程一段就够了
+    int segments = qMax(1, pool->maxThreadCount());
+    QVector<QFuture<QVector<double>>> futures;
+    for (int i = 0; i < segments; i++) {
+        double start = duration * i / segments;
+        double end = duration * (i + 1) / segments;
+        futures.append(QtConcurrent::run(pool, [=]() {
+            // 取消后还没开始的段不再解码
+            if (cancelled->loadAcquire()) {
+                return QVector<double>();
+            }
+            return detectSegment(filePath, start, end);
+        }));
+    }
+
+    QVector<double> all;
+    for (QFuture<QVector<double>> &future : futures) {
+        future.waitForFinished();
+        all += future.result();
+    }
+    std::sort(all.begin(), all.end());
+
+    // 合并离得太近的切换点
+    QVector<double> cuts;
+    for (double t : all) {
+        if (cuts.isEmpty() || t - cuts.last() >= SCENE_MIN_LENGTH) {
+            cuts.append(t);
+        }
+    }
+
+    qDebug() << "镜头检测完成:" << QFileInfo(filePath).fileName() << cuts.size() << "个切换点，用时"
+             << timer.elapsed() << "ms";
+    return cuts;
+}
+
+QVector<double> SceneDetector::detectSegment(const QString &filePath, double startSeconds, double endSeconds)
+{
+    QVector<double> cuts;
+    AVFormatContext *formatCtx = nullptr;
+    AVCodecContext *codecCtx = nullptr;
+    SwsContext *swsCtx = nullptr;
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    uint8_t *thumb[4] = { nullptr };
+    int thumbLinesize[4] = { 0 };
+
+    double threshold = PlayerConfig::sceneThreshold;
+    int histogram[SCENE_HIST_BINS];
+    int lastHistogram[SCENE_HIST_BINS];
+    bool hasLast = false;
+    double nextSample = startSeconds - SCENE_SAMPLE_INTERVAL;
+
+    do {
+        if (avformat_open_input(&formatCtx, filePath.toUtf8().constData(), nullptr, nullptr) < 0) {
+            break;
+        }
+        if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+            break;
+        }
+        int streamIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (streamIndex < 0) {
+            break;
+        }
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+            if ((int)i != streamIndex) {
+                formatCtx->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
+        AVStream *stream = formatCtx->streams[streamIndex];
+        double streamStart = (stream->start_time != AV_NOPTS_VALUE)
+                ? stream->start_time * av_q2d(stream->time_base) : 0.0;
+        const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (!codec) {
+            break;
+        }
+        codecCtx = avcodec_alloc_context3(codec);
+        if (!codecCtx || avcodec_parameters_to_context(codecCtx, stream->codecpar) < 0) {
+            break;
+        }
+        // 多段已经并行了，单个解码器只用一个线程；非参考帧和环路滤波都跳过
+        codecCtx->thread_count = 1;
+        codecCtx->skip_frame = AVDISCARD_NONREF;
+        codecCtx->skip_loop_filter = AVDISCARD_ALL;
+        if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
+            break;
+        }
+
+        if (av_image_alloc(thumb, thumbLinesize, SCENE_THUMB_WIDTH, SCENE_THUMB_HEIGHT,
+                           AV_PIX_FMT_GRAY8, 16) < 0) {
+            break;
+        }
+
+        // 从段起点前一个取样间隔开始，段首的切换也能和前一帧比较
+        if (startSeconds > 0) {
+            int64_t target = (int64_t)((nextSample + streamStart) * AV_TIME_BASE);
+            av_seek_frame(formatCtx, -1, target, AVSEEK_FLAG_BACKWARD);
+        }
+
+        packet = av_packet_alloc();
+        frame = av_frame_alloc();
+        if (!packet || !frame) {
+            break;
+        }
+
+        bool done = false;
+        while (!done) {
+            int ret = av_read_frame(formatCtx, packet);
+            if (ret < 0) {
+                avcodec_send_packet(codecCtx, nullptr);
+                done = true;
+            } else if (packet->stream_index == streamIndex) {
+                avcodec_send_packet(codecCtx, packet);
+                av_packet_unref(packet);
+            } else {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            while (avcodec_receive_frame(codecCtx, frame) >= 0) {
+                int64_t pts = (frame->best_effort_timestamp != AV_NOPTS_VALUE)
+                        ? frame->best_effort_timestamp : frame->pts;
+                if (pts == AV_NOPTS_VALUE) {
+                    av_frame_unref(frame);
+                    continue;
+                }
+                double t = pts * av_q2d(stream->time_base) - streamStart;
+                if (t >= endSeconds) {
+                    done = true;
+                    av_frame_unref(frame);
+                    break;
+                }
+                if (t < nextSample) {
+                    av_frame_unref(frame);
+                    continue;
+                }
+                nextSample = t + SCENE_SAMPLE_INTERVAL;
+
+                swsCtx = sws_getCachedContext(swsCtx, frame->width, frame->height,
+                                              (AVPixelFormat)frame->format,
+                                              SCENE_THUMB_WIDTH, SCENE_THUMB_HEIGHT, AV_PIX_FMT_GRAY8,
+                                              SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+                if (!swsCtx) {
+                    av_frame_unref(frame);
+                    continue;
+                }
+                sws_scale(swsCtx, frame->data, frame->linesize, 0, frame->height, thumb, thumbLinesize);
+                av_frame_unref(frame);
+
+                memset(histogram, 0, sizeof(histogram));
+                for (int y = 0; y < SCENE_THUMB_HEIGHT; y++) {
+                    const uint8_t *row = thumb[0] + y * thumbLinesize[0];
+                    for (int x = 0; x < SCENE_THUMB_WIDTH; x++) {
+                        histogram[row[x] * SCENE_HIST_BINS / 256]++;
+                    }
+                }
+
+                // 直方图L1距离归一化到0~1
+                if (hasLast && t >= startSeconds) {
+                    int diff = 0;
+                    for (int i = 0; i < SCENE_HIST_BINS; i++) {
+                        diff += qAbs(histogram[i] - lastHistogram[i]);
+                    }
+                    double score = diff / (2.0 * SCENE_THUMB_WIDTH * SCENE_THUMB_HEIGHT);
+                    if (score > threshold) {
+                        cuts.append(t);
+                    }
+                }
+                memcpy(lastHistogram, histogram, sizeof(histogram));
+                hasLast = true;
+            }
+        }
+    } while (false);
+
+    av_freep(&thumb[0]);
+    sws_freeContext(swsCtx);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codecCtx);
+    avformat_close_input(&formatCtx);
+    return cuts;
+}
@@ -0,0 +1,54 @@
+#ifndef SCENEDETECTOR_H
+#define SCENEDETECTOR_H
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QThreadPool>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QList>
+
+// 一个文件的跳转索引（秒，升序）
+struct SceneIndex {
+    QVector<double> cuts;       // 镜头切换点
+    QVector<double> chapters;   // 容器里的章节起点，没有镜头数据时用
+
+    const QVector<double> &boundaries() const { return cuts.isEmpty() ? chapters : cuts; }
+};
+
+// 后台镜头检测：按时间分段并行解码，隔一段时间取一帧缩成小灰度图，
+// 相邻取样帧的直方图差异超过阈值就记为一个切换点
+class SceneDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SceneDetector(QObject *parent = nullptr);
+    ~SceneDetector();
+
+    void detect(const QString &filePath);
+
+    // 二分查找当前时间之后/之前的边界，没有索引时返回false
+    bool nextBoundary(const QString &filePath, double seconds, double *target);
+    bool previousBoundary(const QString &filePath, double seconds, double *target);
+
+signals:
+    void sceneIndexReady(QString filePath, int cutCount);
+
+private:
+    static bool readChapters(const QString &filePath, double *duration, QVector<double> *chapters);
+    static QVector<double> computeCuts(QThreadPool *pool, const QAtomicInt *cancelled,
+                                       const QString &filePath, double duration);
+    static QVector<double> detectSegment(const QString &filePath, double startSeconds, double endSeconds);
+
+    QThreadPool m_pool;
+    QList<QFuture<void>> m_drivers;     // 每个文件一个调度任务（析构时等它们结束）
+    QAtomicInt m_cancelled;             // 析构时置位，还没开始的段直接跳过
+    QMutex m_mutex;
+    QHash<QString, SceneIndex> m_indexes;
+    QString m_detecting;
+};
+
+#endif // SCENEDETECTOR_H
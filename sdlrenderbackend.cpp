@@ -0,0 +1,135 @@
+#include "sdlrenderbackend.h"
+#include <QDebug>
+
+SdlRenderBackend::SdlRenderBackend(WId windowId)
+    : m_windowId(windowId)
+{
+}
+
+SdlRenderBackend::~SdlRenderBackend()
+{
+    close();
+
+    // 销毁窗口
+    if (m_window) {
+        SDL_DestroyWindow(m_window);
+        m_window = nullptr;
+    }
+}
+
+bool SdlRenderBackend::open()
+{
+    qDebug() << "开始初始化SDL显示...";
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        qDebug() << "SDL初始化失败:" << SDL_GetError();
+        return false;
+    }
+
+    if (!m_windowId) {
+        qDebug() << "错误：无法获取Qt视频部件的窗口ID";
+        return false;
+    }
+    qDebug() << "Qt视频部件窗口ID：" << m_windowId;
+
+    // 1. 创建SDL窗口（嵌入到Qt窗口中）
+    if (!m_window) {
+        m_window = SDL_CreateWindowFrom((void*)m_windowId);
+    }
+    if (!m_window) {
+        qDebug() << "错误：创建SDL窗口失败：" << SDL_GetError();
+        return false;
+    }
+
+    // 2. 创建SDL渲染器
+    // 尝试使用硬件加速渲染器
+    m_renderer = SDL_CreateRenderer(m_window, -1,
+                                    SDL_RENDERER_ACCELERATED |
+                                    SDL_RENDERER_PRESENTVSYNC);
+
+    // 如果硬件加速失败，尝试软件渲染器
+    if (!m_renderer) {
+        qDebug() << "硬件加速渲染器创建失败，尝试软件渲染：" << SDL_GetError();
+        m_renderer = SDL_CreateRenderer(m_window, -1, SDL_RENDERER_SOFTWARE);
+    }
+
+    if (!m_renderer) {
+        qDebug() << "错误：创建SDL渲染器失败：" << SDL_GetError();
+        return false;
+    }
+
+    qDebug() << "✅ SDL渲染器创建成功";
+
+    // 3. 设置渲染器属性
+    SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);  // 黑色背景
+    SDL_RenderClear(m_renderer);
+    SDL_RenderPresent(m_renderer);
+
+    // 设置纹理缩放质量
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    return true;
+}
+
+void SdlRenderBackend::close()
+{
+    // 1. 销毁纹理
+    if (m_texture) {
+        SDL_DestroyTexture(m_texture);
+        m_texture = nullptr;
+        qDebug() << "SDL纹理已销毁";
+    }
+
+    // 2. 销毁渲染器
+    if (m_renderer) {
+        SDL_DestroyRenderer(m_renderer);
+        m_renderer = nullptr;
+        qDebug() << "SDL渲染器已销毁";
+    }
+}
+
+bool SdlRenderBackend::present(const uint8_t *data, int linesize, int width, int height, double displayAspect)
+{
+    if (!m_renderer) {
+        return false;
+    }
+
+    // 1. 创建或更新SDL纹理（尺寸跟着转换输出变）
+    if (m_texture && (width != m_textureWidth || height != m_textureHeight)) {
+        SDL_DestroyTexture(m_texture);
+        m_texture = nullptr;
+    }
+    if (!m_texture) {
+        m_texture = SDL_CreateTexture(m_renderer,
+                                      SDL_PIXELFORMAT_RGB24,
+                                      SDL_TEXTUREACCESS_STREAMING,
+                                      width,
+                                      height);
+        if (!m_texture) {
+            qDebug() << "创建纹理失败：" << SDL_GetError();
+            return false;
+        }
+        m_textureWidth = width;
+        m_textureHeight = height;
+        qDebug() << "创建新纹理" << width << "x" << height;
+    }
+
+    // 2. 更新纹理数据
+    if (SDL_UpdateTexture(m_texture, NULL, data, linesize) != 0) {
+        qDebug() << "更新纹理失败：" << SDL_GetError();
+        return false;
+    }
+
+    // 3. 渲染（按宽高比留黑边）
+    int outWidth = 0;
+    int outHeight = 0;
+    SDL_GetRendererOutputSize(m_renderer, &outWidth, &outHeight);
+    QRect rect = letterbox(outWidth, outHeight, displayAspect);
+    SDL_Rect dstRect = { rect.x(), rect.y(), rect.width(), rect.height() };
+    SDL_RenderClear(m_renderer);
+    SDL_RenderCopy(m_renderer, m_texture, NULL, &dstRect);
+    SDL_RenderPresent(m_renderer);
+
+    // 4. 强制处理SDL事件（确保显示）
+    SDL_PumpEvents();
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef SDLRENDERBACKEND_H
+#define SDLRENDERBACKEND_H
+
+#include "renderbackend.h"
+#include <QWindow>
+#include <SDL.h>
+
+// SDL渲染器嵌入Qt部件的原生窗口（SDL_CreateWindowFrom），硬件加速失败时退回软件渲染
+class SdlRenderBackend : public RenderBackend
+{
+public:
+    explicit SdlRenderBackend(WId windowId);
+    ~SdlRenderBackend() override;
+
+    const char *name() const override { return "sdl"; }
+    bool open() override;
+    void close() override;
+    bool present(const uint8_t *data, int linesize, int width, int height, double displayAspect) override;
+
+private:
+    WId m_windowId;
+    SDL_Window *m_window = nullptr;
+    SDL_Renderer *m_renderer = nullptr;
+    SDL_Texture *m_texture = nullptr;
+    int m_textureWidth = 0;          // 当前纹理尺寸（跟随转换输出）
+    int m_textureHeight = 0;
+};
+
+#endif // SDLRENDERBACKEND_H
@@ -1,4 +1,5 @@
 #include "seekslider.h"
+#include <QPainter>
 
 SeekSlider::SeekSlider(QWidget *parent)
     : QSlider(Qt::Horizontal, parent)
@@ -69,3 +70,45 @@ void SeekSlider::mouseReleaseEvent(QMouseEvent *event)
 
     QSlider::mouseReleaseEvent(event);
 }
+
+void SeekSlider::setWaveform(const QVector<qint8> &mins, const QVector<qint8> &maxs)
+{
+    waveMins = mins;
+    waveMaxs = maxs;
+    update();
+}
+
+void SeekSlider::clearWaveform()
+{
+    waveMins.clear();
+    waveMaxs.clear();
+    update();
+}
+
+void SeekSlider::paintEvent(QPaintEvent *event)
+{
+    if (!waveMins.isEmpty() && width() > 0) {
+        QPainter painter(this);
+        painter.setPen(QColor(120, 170, 220, 160));
+
+        int buckets = waveMins.size();
+        int mid = height() / 2;
+        double scale = (height() / 2 - 2) / 127.0;
+
+        // 每个像素列取对应桶范围内的最小/最大值
+        for (int x = 0; x < width(); x++) {
+            int first = x * buckets / width();
+            int last = qMax(first + 1, (x + 1) * buckets / width());
+            int lo = 0;
+            int hi = 0;
+            for (int i = first; i < last && i < buckets; i++) {
+                lo = qMin(lo, (int)waveMins[i]);
+                hi = qMax(hi, (int)waveMaxs[i]);
+            }
+            painter.drawLine(x, mid - static_cast<int>(hi * scale),
+                             x, mid - static_cast<int>(lo * scale));
+        }
+    }
+
+    QSlider::paintEvent(event);
+}
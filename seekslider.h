@@ -1,6 +1,8 @@
 // SeekSlider.h
 #include <QSlider>
 #include <QMouseEvent>
+#include <QPaintEvent>
+#include <QVector>
 
 class SeekSlider : public QSlider
 {
@@ -8,11 +10,18 @@ class SeekSlider : public QSlider
 public:
     explicit SeekSlider(QWidget *parent = nullptr);
 
+    // 波形概览（每个桶的最小/最大值，-127~127），画在滑动条后面
+    void setWaveform(const QVector<qint8> &mins, const QVector<qint8> &maxs);
+    void clearWaveform();
+
 protected:
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
 
 private:
     bool isDragging = false;
+    QVector<qint8> waveMins;
+    QVector<qint8> waveMaxs;
 };
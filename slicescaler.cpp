@@ -0,0 +1,180 @@
+#include "slicescaler.h"
+#include "yuvconverter.h"
+#include <QDebug>
+#include <QThread>
+#include <QtConcurrent>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+// 每条至少这么多行，太细的条线程调度开销比转换还大
+static const int MIN_BAND_ROWS = 64;
+
+SliceScaler::SliceScaler()
+{
+    // 线程常驻，不因空闲过期而反复创建
+    m_pool.setExpiryTimeout(-1);
+}
+
+SliceScaler::~SliceScaler()
+{
+    release();
+    m_pool.waitForDone();
+}
+
+int SliceScaler::autoBandCount(int srcWidth, int srcHeight)
+{
+    // 1080p以下一次sws_scale足够快，4K开始分条
+    qint64 pixels = (qint64)srcWidth * srcHeight;
+    if (pixels < 2560LL * 1440LL) {
+        return 1;
+    }
+    return qBound(1, QThread::idealThreadCount(), 16);
+}
+
+bool SliceScaler::init(int srcWidth, int srcHeight, AVPixelFormat srcFormat,
+                       int dstWidth, int dstHeight, AVPixelFormat dstFormat,
+                       int flags, int bands)
+{
+    release();
+
+    m_srcDesc = av_pix_fmt_desc_get(srcFormat);
+    m_dstDesc = av_pix_fmt_desc_get(dstFormat);
+    if (!m_srcDesc || !m_dstDesc || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) {
+        return false;
+    }
+
+    if (bands <= 0) {
+        bands = autoBandCount(srcWidth, srcHeight);
+    }
+    bands = qBound(1, bands, qMax(1, qMin(srcHeight, dstHeight) / MIN_BAND_ROWS));
+
+    // 条的边界要落在色度行上
+    int srcAlign = 1 << m_srcDesc->log2_chroma_h;
+    int dstAlign = 1 << m_dstDesc->log2_chroma_h;
+
+    int prevSrcY = 0;
+    int prevDstY = 0;
+    for (int i = 1; i <= bands; i++) {
+        int srcY = srcHeight;
+        int dstY = dstHeight;
+        if (i < bands) {
+            srcY = (int)((qint64)srcHeight * i / bands) & ~(srcAlign - 1);
+            dstY = (int)(((qint64)srcY * dstHeight + srcHeight / 2) / srcHeight) & ~(dstAlign - 1);
+        }
+        if (srcY <= prevSrcY || dstY <= prevDstY) {
+            continue;
+        }
+
+        Band band;
+        band.srcY = prevSrcY;
+        band.srcH = srcY - prevSrcY;
+        band.dstY = prevDstY;
+        band.dstH = dstY - prevDstY;
+        band.ctx = sws_getContext(srcWidth, band.srcH, srcFormat,
+                                  dstWidth, band.dstH, dstFormat,
+                                  flags, nullptr, nullptr, nullptr);
+        if (!band.ctx) {
+            qDebug() << "分条转换器创建失败";
+            release();
+            return false;
+        }
+        m_bands.append(band);
+
+        prevSrcY = srcY;
+        prevDstY = dstY;
+    }
+
+    m_pool.setMaxThreadCount(qMax(1, m_bands.size() - 1));
+    return !m_bands.isEmpty();
+}
+
+void SliceScaler::release()
+{
+    for (Band &band : m_bands) {
+        sws_freeContext(band.ctx);
+    }
+    m_bands.clear();
+}
+
+void SliceScaler::setColorspace(AVColorSpace colorspace, AVColorRange range)
+{
+    if (m_bands.isEmpty() || (m_srcDesc->flags & AV_PIX_FMT_FLAG_RGB)) {
+        return;
+    }
+
+    int srcHeight = m_bands.last().srcY + m_bands.last().srcH;
+    colorspace = YuvConverter::guessColorspace(colorspace, srcHeight);
+    int swsColorspace = SWS_CS_ITU601;
+    if (colorspace == AVCOL_SPC_BT709) {
+        swsColorspace = SWS_CS_ITU709;
+    } else if (colorspace == AVCOL_SPC_BT2020_NCL || colorspace == AVCOL_SPC_BT2020_CL) {
+        swsColorspace = SWS_CS_BT2020;
+    }
+
+    for (Band &band : m_bands) {
+        int *invTable = nullptr;
+        int *table = nullptr;
+        int srcRange = 0;
+        int dstRange = 0;
+        int brightness = 0;
+        int contrast = 0;
+        int saturation = 0;
+        if (sws_getColorspaceDetails(band.ctx, &invTable, &srcRange, &table, &dstRange,
+                                     &brightness, &contrast, &saturation) < 0) {
+            continue;
+        }
+        // 未标注范围时保留swscale按格式得出的（YUVJ为全范围）
+        if (range != AVCOL_RANGE_UNSPECIFIED) {
+            srcRange = (range == AVCOL_RANGE_JPEG) ? 1 : 0;
+        }
+        sws_setColorspaceDetails(band.ctx, sws_getCoefficients(swsColorspace), srcRange,
+                                 table, dstRange, brightness, contrast, saturation);
+    }
+}
+
+int SliceScaler::scale(const uint8_t *const srcData[], const int srcLinesize[],
+                       uint8_t *const dstData[], const int dstLinesize[])
+{
+    if (m_bands.isEmpty()) {
+        return 0;
+    }
+
+    // 第一条在调用线程上做，其余交给线程池
+    QVector<QFuture<void>> futures;
+    for (int i = 1; i < m_bands.size(); i++) {
+        const Band &band = m_bands.at(i);
+        futures.append(QtConcurrent::run(&m_pool, [this, &band, srcData, srcLinesize, dstData, dstLinesize]() {
+            scaleBand(band, srcData, srcLinesize, dstData, dstLinesize);
+        }));
+    }
+    scaleBand(m_bands.first(), srcData, srcLinesize, dstData, dstLinesize);
+
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+    return m_bands.last().dstY + m_bands.last().dstH;
+}
+
+void SliceScaler::scaleBand(const Band &band, const uint8_t *const srcData[], const int srcLinesize[],
+                            uint8_t *const dstData[], const int dstLinesize[])
+{
+    // 按平面算出本条的起始指针（色度平面按垂直采样比例偏移）
+    const uint8_t *src[4] = { nullptr };
+    uint8_t *dst[4] = { nullptr };
+    for (int p = 0; p < 4; p++) {
+        if (srcData[p]) {
+            bool chroma = (p == 1 || p == 2) && !(m_srcDesc->flags & AV_PIX_FMT_FLAG_RGB);
+            int y = chroma ? (band.srcY >> m_srcDesc->log2_chroma_h) : band.srcY;
+            src[p] = srcData[p] + (ptrdiff_t)y * srcLinesize[p];
+        }
+        if (dstData[p]) {
+            bool chroma = (p == 1 || p == 2) && !(m_dstDesc->flags & AV_PIX_FMT_FLAG_RGB);
+            int y = chroma ? (band.dstY >> m_dstDesc->log2_chroma_h) : band.dstY;
+            dst[p] = dstData[p] + (ptrdiff_t)y * dstLinesize[p];
+        }
+    }
+
+    sws_scale(band.ctx, src, srcLinesize, 0, band.srcH, dst, dstLinesize);
+}
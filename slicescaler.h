@@ -0,0 +1,57 @@
+#ifndef SLICESCALER_H
+#define SLICESCALER_H
+
+#include <QVector>
+#include <QThreadPool>
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+// 分条并行的颜色转换：把画面按行切成若干横条，每条一个SwsContext，
+// 由常驻线程池同时转换（4K/8K下单次sws_scale超过一帧的时间）
+// 有纵向缩放时各条在边界处按各自的源行取样，接缝处与整帧转换有细微差别
+class SliceScaler
+{
+public:
+    SliceScaler();
+    ~SliceScaler();
+
+    // bands<=0时按源尺寸自动选择条数
+    bool init(int srcWidth, int srcHeight, AVPixelFormat srcFormat,
+              int dstWidth, int dstHeight, AVPixelFormat dstFormat,
+              int flags, int bands = 0);
+    void release();
+    // 按帧标注的矩阵和范围设置YUV输入的系数（swscale默认一律按BT.601）
+    void setColorspace(AVColorSpace colorspace, AVColorRange range);
+
+    bool isValid() const { return !m_bands.isEmpty(); }
+    int bandCount() const { return m_bands.size(); }
+
+    // 转换整帧，返回输出的行数
+    int scale(const uint8_t *const srcData[], const int srcLinesize[],
+              uint8_t *const dstData[], const int dstLinesize[]);
+
+    static int autoBandCount(int srcWidth, int srcHeight);
+
+private:
+    struct Band {
+        SwsContext *ctx = nullptr;
+        int srcY = 0;
+        int srcH = 0;
+        int dstY = 0;
+        int dstH = 0;
+    };
+
+    void scaleBand(const Band &band, const uint8_t *const srcData[], const int srcLinesize[],
+                   uint8_t *const dstData[], const int dstLinesize[]);
+
+    QVector<Band> m_bands;
+    const AVPixFmtDescriptor *m_srcDesc = nullptr;
+    const AVPixFmtDescriptor *m_dstDesc = nullptr;
+    QThreadPool m_pool;
+};
+
+#endif // SLICESCALER_H
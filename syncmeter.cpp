@@ -0,0 +1,106 @@
+#include "syncmeter.h"
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/time.h>
+}
+
+// 超过1/4满幅算有声，低于1/32算静音；静音满50毫秒后再有声才算新的一声
+static const int LOUD_LEVEL = 8192;
+static const int QUIET_LEVEL = 1024;
+static const int QUIET_MS = 50;
+
+void SyncMeter::played(const uint8_t *pcm, int len, int sampleRate, int channels)
+{
+    if (sampleRate <= 0 || channels <= 0) {
+        return;
+    }
+
+    // 回调时刻就是这块数据开始播放的时刻（dummy驱动取完数据后才按时长等待）
+    qint64 now = av_gettime_relative();
+    const int16_t *samples = reinterpret_cast<const int16_t*>(pcm);
+    int count = len / (2 * channels);
+    qint64 quietNeeded = (qint64)sampleRate * QUIET_MS / 1000;
+
+    QMutexLocker locker(&m_mutex);
+    for (int n = 0; n < count; n++) {
+        int level = qAbs((int)samples[n * channels]);
+        if (level >= LOUD_LEVEL && m_quietSamples >= quietNeeded) {
+            m_beeps.append(now + (qint64)n * 1000000 / sampleRate);
+        }
+        m_quietSamples = (level < QUIET_LEVEL) ? m_quietSamples + 1 : 0;
+    }
+}
+
+QVector<qint64> SyncMeter::beepTimes()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_beeps;
+}
+
+QVector<qint64> SyncMeter::flashTimes(const QVector<OffscreenRenderBackend::Frame> &frames)
+{
+    QVector<qint64> flashes;
+    bool lastBright = false;
+    for (const OffscreenRenderBackend::Frame &frame : frames) {
+        bool bright = frame.brightness > 128;
+        if (bright && !lastBright) {
+            flashes.append(frame.presentUs);
+        }
+        lastBright = bright;
+    }
+    return flashes;
+}
+
+SyncMeter::Result SyncMeter::measure(const QVector<qint64> &flashes, const QVector<qint64> &beeps, qint64 maxGapUs)
+{
+    Result result;
+    QVector<double> offsets;            // 毫秒
+    QVector<double> times;              // 距第一个闪白的分钟数
+    for (qint64 flash : flashes) {
+        qint64 best = -1;
+        for (qint64 beep : beeps) {
+            if (best < 0 || qAbs(flash - beep) < qAbs(flash - best)) {
+                best = beep;
+            }
+        }
+        if (best < 0 || qAbs(flash - best) > maxGapUs) {
+            result.missed++;
+            continue;
+        }
+        offsets.append((flash - best) / 1000.0);
+        times.append((flash - flashes.first()) / 60e6);
+    }
+    result.events = offsets.size();
+    result.missed += qMax(0, beeps.size() - result.events);
+    if (offsets.isEmpty()) {
+        return result;
+    }
+
+    double sum = 0;
+    QVector<double> magnitudes;
+    for (double offset : offsets) {
+        sum += offset;
+        magnitudes.append(std::fabs(offset));
+    }
+    std::sort(magnitudes.begin(), magnitudes.end());
+    result.meanMs = sum / offsets.size();
+    result.p95Ms = magnitudes.at(qMax(0, (int)std::ceil(magnitudes.size() * 0.95) - 1));
+    result.maxMs = magnitudes.last();
+
+    // 最小二乘斜率
+    double meanTime = 0;
+    for (double time : times) {
+        meanTime += time;
+    }
+    meanTime /= times.size();
+    double covariance = 0;
+    double variance = 0;
+    for (int i = 0; i < times.size(); i++) {
+        covariance += (times[i] - meanTime) * (offsets[i] - result.meanMs);
+        variance += (times[i] - meanTime) * (times[i] - meanTime);
+    }
+    result.driftMsPerMin = (variance > 0) ? covariance / variance : 0;
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef SYNCMETER_H
+#define SYNCMETER_H
+
+#include <QMutex>
+#include <QVector>
+#include "audiothread.h"
+#include "offscreenrenderbackend.h"
+
+// 音画同步测量：作为音频输出旁路找响声起点，再从离屏视频的记录里找闪白，
+// 两边按时间配对后算偏差（都用av_gettime_relative的微秒时刻）
+class SyncMeter : public AudioTap
+{
+public:
+    struct Result {
+        int events = 0;                 // 配上对的闪白/响声
+        int missed = 0;                 // 只出现了一边的
+        double meanMs = 0;              // 平均偏差（画面减声音，正数为画面晚）
+        double p95Ms = 0;               // |偏差|的95分位
+        double maxMs = 0;               // |偏差|最大值
+        double driftMsPerMin = 0;       // 偏差随播放时间的变化（线性拟合斜率）
+    };
+
+    void played(const uint8_t *pcm, int len, int sampleRate, int channels) override;
+
+    QVector<qint64> beepTimes();
+
+    // 画面由暗变亮的时刻
+    static QVector<qint64> flashTimes(const QVector<OffscreenRenderBackend::Frame> &frames);
+
+    // 每个闪白配最近的响声，相差超过maxGapUs算没配上
+    static Result measure(const QVector<qint64> &flashes, const QVector<qint64> &beeps, qint64 maxGapUs);
+
+private:
+    QMutex m_mutex;
+    QVector<qint64> m_beeps;            // 响声起点
+    qint64 m_quietSamples = 0;          // 连续静音的样本数
+};
+
+#endif // SYNCMETER_H
@@ -0,0 +1,325 @@
+#include "testclip.h"
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/mathematics.h>
+}
+
+// 一路输出流：编码器、待送的帧和下一帧的pts（编码器时间基）
+struct ClipStream {
+    AVStream *stream = nullptr;
+    AVCodecContext *codecCtx = nullptr;
+    AVFrame *frame = nullptr;
+    int64_t next = 0;
+};
+
+// 送一帧（nullptr表示冲刷）并把编出的包写进文件
+static bool encodeFrame(AVFormatContext *formatCtx, ClipStream &out, const AVFrame *frame, AVPacket *packet)
+{
+    if (avcodec_send_frame(out.codecCtx, frame) < 0) {
+        return false;
+    }
+    while (true) {
+        int ret = avcodec_receive_packet(out.codecCtx, packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if (ret < 0) {
+            return false;
+        }
+        av_packet_rescale_ts(packet, out.codecCtx->time_base, out.stream->time_base);
+        packet->stream_index = out.stream->index;
+        ret = av_interleaved_write_frame(formatCtx, packet);
+        av_packet_unref(packet);
+        if (ret < 0) {
+            return false;
+        }
+    }
+}
+
+static bool openStream(AVFormatContext *formatCtx, ClipStream &out, const AVCodec *codec)
+{
+    out.codecCtx->thread_count = 1;
+    out.codecCtx->flags |= AV_CODEC_FLAG_BITEXACT;
+    if (formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
+        out.codecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    if (avcodec_open2(out.codecCtx, codec, nullptr) < 0 ||
+            avcodec_parameters_from_context(out.stream->codecpar, out.codecCtx) < 0) {
+        return false;
+    }
+    out.stream->time_base = out.codecCtx->time_base;
+    return true;
+}
+
+static bool openVideo(AVFormatContext *formatCtx, ClipStream &out, const TestClip::Params &params)
+{
+    const AVCodec *codec = avcodec_find_encoder(params.videoCodec);
+    if (!codec || !(out.stream = avformat_new_stream(formatCtx, nullptr)) ||
+            !(out.codecCtx = avcodec_alloc_context3(codec))) {
+        return false;
+    }
+
+    AVCodecContext *codecCtx = out.codecCtx;
+    codecCtx->width = params.width;
+    codecCtx->height = params.height;
+    // mpeg4为YUV420P，mjpeg为YUVJ420P，都是三平面4:2:0
+    codecCtx->pix_fmt = codec->pix_fmts ? codec->pix_fmts[0] : AV_PIX_FMT_YUV420P;
+    codecCtx->time_base = av_inv_q(params.frameRate);
+    codecCtx->framerate = params.frameRate;
+    codecCtx->gop_size = params.gopSize;
+    codecCtx->max_b_frames = params.maxBFrames;
+    // 固定量化，码率控制不会因机器快慢产生差异
+    codecCtx->flags |= AV_CODEC_FLAG_QSCALE;
+    codecCtx->global_quality = FF_QP2LAMBDA * 3;
+    if (!openStream(formatCtx, out, codec)) {
+        return false;
+    }
+    out.stream->avg_frame_rate = params.frameRate;
+
+    out.frame = av_frame_alloc();
+    if (!out.frame) {
+        return false;
+    }
+    out.frame->format = codecCtx->pix_fmt;
+    out.frame->width = params.width;
+    out.frame->height = params.height;
+    return av_frame_get_buffer(out.frame, 32) >= 0;
+}
+
+static bool openAudio(AVFormatContext *formatCtx, ClipStream &out, const TestClip::Params &params)
+{
+    const AVCodec *codec = avcodec_find_encoder(params.audioCodec);
+    if (!codec || !(out.stream = avformat_new_stream(formatCtx, nullptr)) ||
+            !(out.codecCtx = avcodec_alloc_context3(codec))) {
+        return false;
+    }
+
+    AVCodecContext *codecCtx = out.codecCtx;
+    // aac只收FLTP，mp2/pcm收S16
+    codecCtx->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_S16;
+    codecCtx->sample_rate = params.sampleRate;
+    codecCtx->channel_layout = AV_CH_LAYOUT_STEREO;
+    codecCtx->channels = 2;
+    codecCtx->bit_rate = 128000;
+    codecCtx->time_base = { 1, params.sampleRate };
+    if (!openStream(formatCtx, out, codec)) {
+        return false;
+    }
+
+    out.frame = av_frame_alloc();
+    if (!out.frame) {
+        return false;
+    }
+    bool variable = (codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE) || codecCtx->frame_size <= 0;
+    out.frame->nb_samples = variable ? 1024 : codecCtx->frame_size;
+    out.frame->format = codecCtx->sample_fmt;
+    out.frame->channel_layout = codecCtx->channel_layout;
+    out.frame->channels = codecCtx->channels;
+    out.frame->sample_rate = codecCtx->sample_rate;
+    return av_frame_get_buffer(out.frame, 0) >= 0;
+}
+
+// 闪白帧：暗场；其他帧：帧号图案
+static void drawVideo(AVFrame *frame, int index, const TestClip::Params &params, const QVector<int> &flashes)
+{
+    if (params.flashPeriodMs <= 0) {
+        TestClip::drawFrame(frame, index);
+        return;
+    }
+
+    uint8_t luma = flashes.contains(index) ? 235 : 32;
+    for (int y = 0; y < frame->height; y++) {
+        memset(frame->data[0] + y * frame->linesize[0], luma, frame->width);
+    }
+    for (int plane = 1; plane < 3; plane++) {
+        for (int y = 0; y < (frame->height + 1) / 2; y++) {
+            memset(frame->data[plane] + y * frame->linesize[plane], 128, (frame->width + 1) / 2);
+        }
+    }
+}
+
+// 静音，每个闪白帧的时刻开始响beepMs毫秒1kHz正弦（半幅）
+static void fillAudio(AVFrame *frame, int64_t firstSample, const TestClip::Params &params,
+                      const QVector<int64_t> &beepStarts)
+{
+    AVSampleFormat format = (AVSampleFormat)frame->format;
+    bool planar = av_sample_fmt_is_planar(format);
+    int channels = frame->channels;
+    int64_t beepSamples = (int64_t)params.beepMs * params.sampleRate / 1000;
+
+    for (int n = 0; n < frame->nb_samples; n++) {
+        int64_t sample = firstSample + n;
+        double value = 0;
+        for (int64_t start : beepStarts) {
+            if (sample >= start && sample < start + beepSamples) {
+                value = 0.5 * std::sin(2.0 * 3.14159265358979 * 1000.0 * (sample - start) / params.sampleRate);
+                break;
+            }
+        }
+
+        for (int ch = 0; ch < channels; ch++) {
+            int plane = planar ? ch : 0;
+            int offset = planar ? n : n * channels + ch;
+            if (format == AV_SAMPLE_FMT_FLTP || format == AV_SAMPLE_FMT_FLT) {
+                ((float*)frame->data[plane])[offset] = (float)value;
+            } else {
+                ((int16_t*)frame->data[plane])[offset] = (int16_t)std::lrint(value * 32767);
+            }
+        }
+    }
+}
+
+static void freeStream(ClipStream &out)
+{
+    av_frame_free(&out.frame);
+    avcodec_free_context(&out.codecCtx);
+}
+
+bool TestClip::write(const QString &path, const Params &params)
+{
+    QByteArray file = path.toUtf8();
+    AVFormatContext *formatCtx = nullptr;
+    if (avformat_alloc_output_context2(&formatCtx, nullptr, nullptr, file.constData()) < 0) {
+        qDebug() << "测试片段：无法创建输出" << path;
+        return false;
+    }
+    // 不写编码器版本等信息，文件内容只由参数决定
+    formatCtx->flags |= AVFMT_FLAG_BITEXACT;
+
+    bool hasAudio = (params.audioCodec != AV_CODEC_ID_NONE);
+    ClipStream video;
+    ClipStream audio;
+    AVPacket *packet = av_packet_alloc();
+    bool ok = packet && openVideo(formatCtx, video, params);
+    if (ok && hasAudio) {
+        ok = openAudio(formatCtx, audio, params);
+    }
+
+    // 闪白帧和对应的响声起点（样本号），两者在媒体时间上完全重合
+    QVector<int> flashes = flashFrames(params);
+    QVector<int64_t> beepStarts;
+    for (int index : flashes) {
+        beepStarts.append(av_rescale_q(index, av_inv_q(params.frameRate), { 1, params.sampleRate }));
+    }
+    int64_t totalSamples = av_rescale_q(params.frames, av_inv_q(params.frameRate), { 1, params.sampleRate });
+
+    bool headerWritten = false;
+    if (ok && !(formatCtx->oformat->flags & AVFMT_NOFILE)) {
+        ok = avio_open(&formatCtx->pb, file.constData(), AVIO_FLAG_WRITE) >= 0;
+    }
+    if (ok) {
+        ok = headerWritten = avformat_write_header(formatCtx, nullptr) >= 0;
+    }
+
+    // 两路按时间先后交替编码，交错写入
+    while (ok) {
+        bool videoLeft = video.next < params.frames;
+        bool audioLeft = hasAudio && audio.next < totalSamples;
+        if (!videoLeft && !audioLeft) {
+            break;
+        }
+        bool pickVideo = videoLeft && (!audioLeft ||
+                av_compare_ts(video.next, video.codecCtx->time_base, audio.next, audio.codecCtx->time_base) <= 0);
+        ClipStream &out = pickVideo ? video : audio;
+
+        ok = av_frame_make_writable(out.frame) >= 0;
+        if (!ok) {
+            break;
+        }
+        if (pickVideo) {
+            drawVideo(out.frame, (int)out.next, params, flashes);
+            out.frame->pts = out.next++;
+        } else {
+            fillAudio(out.frame, out.next, params, beepStarts);
+            out.frame->pts = out.next;
+            out.next += out.frame->nb_samples;
+        }
+        ok = encodeFrame(formatCtx, out, out.frame, packet);
+    }
+
+    if (headerWritten) {
+        ok = encodeFrame(formatCtx, video, nullptr, packet) && ok;
+        if (hasAudio) {
+            ok = encodeFrame(formatCtx, audio, nullptr, packet) && ok;
+        }
+        ok = av_write_trailer(formatCtx) >= 0 && ok;
+    }
+
+    if (!ok) {
+        qDebug() << "测试片段：编码失败" << path;
+    }
+
+    if (formatCtx->pb && !(formatCtx->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&formatCtx->pb);
+    }
+    av_packet_free(&packet);
+    freeStream(video);
+    freeStream(audio);
+    avformat_free_context(formatCtx);
+    return ok;
+}
+
+void TestClip::drawFrame(AVFrame *frame, int index)
+{
+    int width = frame->width;
+    int height = frame->height;
+
+    // 亮度：随帧号斜向移动的渐变
+    for (int y = 0; y < height; y++) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < width; x++) {
+            row[x] = (uint8_t)((x + y + index * 3) & 0xff);
+        }
+    }
+
+    // 顶部一行16x16方块按二进制写出帧号（白1黑0），跳错一帧画面也不同
+    const int block = 16;
+    for (int bit = 0; bit < 16 && (bit + 1) * block <= width; bit++) {
+        uint8_t value = ((index >> bit) & 1) ? 235 : 16;
+        for (int y = 0; y < block && y < height; y++) {
+            uint8_t *row = frame->data[0] + y * frame->linesize[0] + bit * block;
+            for (int x = 0; x < block; x++) {
+                row[x] = value;
+            }
+        }
+    }
+
+    // 色度：慢慢变化的色块
+    for (int y = 0; y < (height + 1) / 2; y++) {
+        uint8_t *u = frame->data[1] + y * frame->linesize[1];
+        uint8_t *v = frame->data[2] + y * frame->linesize[2];
+        for (int x = 0; x < (width + 1) / 2; x++) {
+            u[x] = (uint8_t)(128 + ((x + index) & 0x3f) - 32);
+            v[x] = (uint8_t)(128 + ((y * 2 + index) & 0x3f) - 32);
+        }
+    }
+}
+
+int TestClip::durationMs(const Params &params)
+{
+    return static_cast<int>(av_rescale_q(params.frames, av_inv_q(params.frameRate), { 1, 1000 }));
+}
+
+QVector<int> TestClip::flashFrames(const Params &params)
+{
+    QVector<int> flashes;
+    if (params.flashPeriodMs <= 0) {
+        return flashes;
+    }
+    AVRational frameDuration = av_inv_q(params.frameRate);
+    int64_t lastPeriod = 0;
+    for (int i = 0; i < params.frames; i++) {
+        // 每个间隔里时间最早的一帧
+        int64_t period = av_rescale_q_rnd(i, frameDuration, { 1, 1000 }, AV_ROUND_UP) / params.flashPeriodMs;
+        if (period != lastPeriod) {
+            flashes.append(i);
+            lastPeriod = period;
+        }
+    }
+    return flashes;
+}
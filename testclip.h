@@ -0,0 +1,46 @@
+#ifndef TESTCLIP_H
+#define TESTCLIP_H
+
+#include <QString>
+#include <QVector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/rational.h>
+}
+
+// 用FFmpeg编码合成测试片段，供回归测试和基准测试使用：
+// 默认画面为移动渐变 + 顶部帧号方块；flashPeriodMs>0时改为暗场定时闪白，音轨在同一时刻响一声
+// 编码器和封装都设为bitexact、单线程，同一版本FFmpeg生成的文件逐字节相同
+class TestClip
+{
+public:
+    struct Params {
+        int width = 320;
+        int height = 240;
+        AVRational frameRate = { 25, 1 };
+        int frames = 75;
+        int gopSize = 12;               // 1为全关键帧
+        int maxBFrames = 2;             // B帧让解码顺序和显示顺序不同
+        AVCodecID videoCodec = AV_CODEC_ID_MPEG4;
+        AVCodecID audioCodec = AV_CODEC_ID_NONE;    // NONE为不带音轨
+        int sampleRate = 48000;
+        int flashPeriodMs = 0;          // 闪白/响声间隔（毫秒），0为不闪
+        int beepMs = 40;                // 每声长度（1kHz正弦）
+    };
+
+    // 按扩展名选封装（如.mp4/.mkv）
+    static bool write(const QString &path, const Params &params);
+
+    // 画第index帧（三平面4:2:0），每帧内容都不同
+    static void drawFrame(AVFrame *frame, int index);
+
+    // 片段时长（毫秒）
+    static int durationMs(const Params &params);
+
+    // 闪白的帧号（从第二个间隔开始，第一帧pts为0不会被播放器显示）
+    static QVector<int> flashFrames(const Params &params);
+};
+
+#endif // TESTCLIP_H
@@ -0,0 +1,403 @@
+#include "tonemapper.h"
+#include "yuvconverter.h"
+#include <QDebug>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/mastering_display_metadata.h>
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TONE_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// 向量函数单独按AVX2编译（MSVC不需要）
+#if defined(__GNUC__) || defined(__clang__)
+#define TONE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TONE_TARGET_AVX2
+#endif
+
+// SDR参考白对应的HDR亮度（BT.2408），线性光1.0即这个亮度
+static const double REFERENCE_WHITE_NITS = 203.0;
+
+// Hable曲线参数
+static const float HABLE_A = 0.15f;
+static const float HABLE_B = 0.50f;
+static const float HABLE_C = 0.10f;
+static const float HABLE_D = 0.20f;
+static const float HABLE_E = 0.02f;
+static const float HABLE_F = 0.30f;
+
+// BT.2020非恒定亮度的Y'CbCr -> R'G'B'
+static const float K_RV = 1.4746f;
+static const float K_GU = 0.16455f;
+static const float K_GV = 0.57135f;
+static const float K_BU = 1.8814f;
+
+static inline float hable(float x)
+{
+    return (x * (HABLE_A * x + HABLE_C * HABLE_B) + HABLE_D * HABLE_E) /
+            (x * (HABLE_A * x + HABLE_B) + HABLE_D * HABLE_F) - HABLE_E / HABLE_F;
+}
+
+static inline int lutIndex(float value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (int)(value * (ToneMapper::LUT_SIZE - 1) + 0.5f);
+}
+
+// 输出查表按平方根取下标，暗部的级数和8位输出相当
+static inline int oetfIndex(float linear)
+{
+    return lutIndex(std::sqrt(linear < 0.0f ? 0.0f : linear));
+}
+
+static inline float applyCurve(const ToneMapper::Params &p, float x)
+{
+    if (p.curve == ToneMapper::CurveHable) {
+        return hable(x) * p.curveScale;
+    }
+    if (p.curve == ToneMapper::CurveReinhard) {
+        return x * (1.0f + x * p.curveScale) / (1.0f + x);
+    }
+    return x;
+}
+
+// 转换一行中[from, to)的像素；chromaStep为色度样本间距（平面1，P010为2）
+static void tonemapRowScalar(const ToneMapper::Params &p,
+                             const uint16_t *y, const uint16_t *u, const uint16_t *v, int chromaStep,
+                             uint8_t *dst, int from, int to)
+{
+    for (int x = from; x < to; x++) {
+        int ci = (x >> 1) * chromaStep;
+        float yf = ((y[x] >> p.shift) - p.yOffset) * p.yScale;
+        float cb = ((u[ci] >> p.shift) - 512.0f) * p.chromaScale;
+        float cr = ((v[ci] >> p.shift) - 512.0f) * p.chromaScale;
+
+        float r = p.eotf[lutIndex(yf + K_RV * cr)];
+        float g = p.eotf[lutIndex(yf - K_GU * cb - K_GV * cr)];
+        float b = p.eotf[lutIndex(yf + K_BU * cb)];
+
+        float linear[3];
+        for (int c = 0; c < 3; c++) {
+            const float *row = p.gamut + c * 3;
+            float value = row[0] * r + row[1] * g + row[2] * b;
+            linear[c] = applyCurve(p, value < 0.0f ? 0.0f : value);
+        }
+
+        uint8_t *out = dst + x * 3;
+        out[0] = (uint8_t)p.oetf[oetfIndex(linear[0])];
+        out[1] = (uint8_t)p.oetf[oetfIndex(linear[1])];
+        out[2] = (uint8_t)p.oetf[oetfIndex(linear[2])];
+    }
+}
+
+#ifdef TONE_HAVE_X86
+TONE_TARGET_AVX2
+static inline __m256i lutIndexAvx2(__m256 value)
+{
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    value = _mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(ToneMapper::LUT_SIZE - 1)), _mm256_set1_ps(0.5f));
+    return _mm256_cvttps_epi32(value);
+}
+
+// 与oetfIndex一致（开方是精确舍入的，和标量逐位相同）
+TONE_TARGET_AVX2
+static inline __m256i oetfIndexAvx2(__m256 linear)
+{
+    return lutIndexAvx2(_mm256_sqrt_ps(_mm256_max_ps(linear, _mm256_setzero_ps())));
+}
+
+TONE_TARGET_AVX2
+static inline __m256 applyCurveAvx2(const ToneMapper::Params &p, __m256 x)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(p.curveScale);
+    if (p.curve == ToneMapper::CurveHable) {
+        const __m256 a = _mm256_set1_ps(HABLE_A);
+        __m256 num = _mm256_add_ps(_mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(a, x), _mm256_set1_ps(HABLE_C * HABLE_B))),
+                                   _mm256_set1_ps(HABLE_D * HABLE_E));
+        __m256 den = _mm256_add_ps(_mm256_mul_ps(x, _mm256_add_ps(_mm256_mul_ps(a, x), _mm256_set1_ps(HABLE_B))),
+                                   _mm256_set1_ps(HABLE_D * HABLE_F));
+        __m256 f = _mm256_sub_ps(_mm256_div_ps(num, den), _mm256_set1_ps(HABLE_E / HABLE_F));
+        return _mm256_mul_ps(f, scale);
+    }
+    if (p.curve == ToneMapper::CurveReinhard) {
+        __m256 num = _mm256_mul_ps(x, _mm256_add_ps(one, _mm256_mul_ps(x, scale)));
+        return _mm256_div_ps(num, _mm256_add_ps(one, x));
+    }
+    return x;
+}
+
+// 每次8个像素，返回处理到的位置；RGB24按16字节重叠写，要求后面还有2个像素
+TONE_TARGET_AVX2
+static int tonemapRowAvx2(const ToneMapper::Params &p,
+                          const uint16_t *y, const uint16_t *u, const uint16_t *v,
+                          uint8_t *dst, int width)
+{
+    const __m128i shift = _mm_cvtsi32_si128(p.shift);
+    const __m128i splitU = _mm_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+    const __m128i splitV = _mm_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+    const __m256 yOffset = _mm256_set1_ps(p.yOffset);
+    const __m256 yScale = _mm256_set1_ps(p.yScale);
+    const __m256 chromaBias = _mm256_set1_ps(512.0f);
+    const __m256 chromaScale = _mm256_set1_ps(p.chromaScale);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i packRgb = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                             0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    __m256 gamut[9];
+    for (int i = 0; i < 9; i++) {
+        gamut[i] = _mm256_set1_ps(p.gamut[i]);
+    }
+
+    int x = 0;
+    for (; x <= width - 10; x += 8) {
+        __m128i y16 = _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(y + x)), shift);
+        __m128i u16;
+        __m128i v16;
+        if (p.interleaved) {
+            __m128i uv = _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(u + x)), shift);
+            u16 = _mm_shuffle_epi8(uv, splitU);
+            v16 = _mm_shuffle_epi8(uv, splitV);
+        } else {
+            u16 = _mm_loadl_epi64((const __m128i *)(u + x / 2));
+            v16 = _mm_loadl_epi64((const __m128i *)(v + x / 2));
+            u16 = _mm_unpacklo_epi16(u16, u16);
+            v16 = _mm_unpacklo_epi16(v16, v16);
+        }
+
+        __m256 yf = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(y16)), yOffset), yScale);
+        __m256 cb = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(u16)), chromaBias), chromaScale);
+        __m256 cr = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v16)), chromaBias), chromaScale);
+
+        __m256 r = _mm256_add_ps(yf, _mm256_mul_ps(_mm256_set1_ps(K_RV), cr));
+        __m256 g = _mm256_sub_ps(_mm256_sub_ps(yf, _mm256_mul_ps(_mm256_set1_ps(K_GU), cb)),
+                                 _mm256_mul_ps(_mm256_set1_ps(K_GV), cr));
+        __m256 b = _mm256_add_ps(yf, _mm256_mul_ps(_mm256_set1_ps(K_BU), cb));
+        r = _mm256_i32gather_ps(p.eotf, lutIndexAvx2(r), 4);
+        g = _mm256_i32gather_ps(p.eotf, lutIndexAvx2(g), 4);
+        b = _mm256_i32gather_ps(p.eotf, lutIndexAvx2(b), 4);
+
+        __m256i out[3];
+        for (int c = 0; c < 3; c++) {
+            __m256 value = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(gamut[c * 3], r),
+                                                       _mm256_mul_ps(gamut[c * 3 + 1], g)),
+                                         _mm256_mul_ps(gamut[c * 3 + 2], b));
+            value = applyCurveAvx2(p, _mm256_max_ps(value, zero));
+            out[c] = _mm256_i32gather_epi32(p.oetf, oetfIndexAvx2(value), 4);
+        }
+
+        // 每个32位放一个像素的R/G/B，再每128位压成12字节
+        __m256i pixels = _mm256_or_si256(out[0], _mm256_or_si256(_mm256_slli_epi32(out[1], 8),
+                                                                   _mm256_slli_epi32(out[2], 16)));
+        pixels = _mm256_shuffle_epi8(pixels, packRgb);
+        uint8_t *o = dst + x * 3;
+        _mm_storeu_si128((__m128i *)o, _mm256_castsi256_si128(pixels));
+        _mm_storeu_si128((__m128i *)(o + 12), _mm256_extracti128_si256(pixels, 1));
+    }
+    return x;
+}
+#endif
+
+ToneMapper::ToneMapper()
+{
+    m_pool.setExpiryTimeout(-1);
+    m_timing.name = "tonemap";
+}
+
+ToneMapper::~ToneMapper()
+{
+    m_pool.waitForDone();
+}
+
+bool ToneMapper::supports(AVPixelFormat srcFormat)
+{
+    return srcFormat == AV_PIX_FMT_YUV420P10LE || srcFormat == AV_PIX_FMT_P010LE;
+}
+
+bool ToneMapper::isHdr(int transfer)
+{
+    return transfer == AVCOL_TRC_SMPTE2084 || transfer == AVCOL_TRC_ARIB_STD_B67;
+}
+
+bool ToneMapper::curveFromName(const QString &name, Curve *curve)
+{
+    if (name == "hable") {
+        *curve = CurveHable;
+    } else if (name == "reinhard") {
+        *curve = CurveReinhard;
+    } else if (name == "clip") {
+        *curve = CurveClip;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double ToneMapper::framePeakNits(const AVFrame *frame)
+{
+    AVFrameSideData *side = av_frame_get_side_data(frame, AV_FRAME_DATA_CONTENT_LIGHT_LEVEL);
+    if (side) {
+        const AVContentLightMetadata *light = (const AVContentLightMetadata *)side->data;
+        if (light->MaxCLL > 0) {
+            return light->MaxCLL;
+        }
+    }
+    side = av_frame_get_side_data(frame, AV_FRAME_DATA_MASTERING_DISPLAY_METADATA);
+    if (side) {
+        const AVMasteringDisplayMetadata *mastering = (const AVMasteringDisplayMetadata *)side->data;
+        if (mastering->has_luminance && mastering->max_luminance.num > 0) {
+            return av_q2d(mastering->max_luminance);
+        }
+    }
+    return 0;
+}
+
+bool ToneMapper::init(int width, int height, AVPixelFormat srcFormat,
+                      AVColorTransferCharacteristic transfer, AVColorRange range,
+                      Curve curve, double peakNits)
+{
+    m_valid = false;
+    if (!supports(srcFormat) || !isHdr(transfer) || width <= 0 || height <= 0) {
+        return false;
+    }
+    peakNits = qMax(peakNits, REFERENCE_WHITE_NITS);
+    double peak = peakNits / REFERENCE_WHITE_NITS;
+
+    // EOTF：R'G'B'码值 -> 线性光
+    m_eotf.resize(LUT_SIZE);
+    for (int i = 0; i < LUT_SIZE; i++) {
+        double e = i / double(LUT_SIZE - 1);
+        double nits = 0;
+        if (transfer == AVCOL_TRC_SMPTE2084) {
+            const double m1 = 0.1593017578125;
+            const double m2 = 78.84375;
+            const double c1 = 0.8359375;
+            const double c2 = 18.8515625;
+            const double c3 = 18.6875;
+            double ep = std::pow(e, 1.0 / m2);
+            nits = 10000.0 * std::pow(qMax(ep - c1, 0.0) / (c2 - c3 * ep), 1.0 / m1);
+        } else {
+            // HLG反OETF得到场景光，OOTF（系统伽马1.2）按分量近似
+            const double a = 0.17883277;
+            const double b = 0.28466892;
+            const double c = 0.55991073;
+            double scene = (e <= 0.5) ? e * e / 3.0 : (std::exp((e - c) / a) + b) / 12.0;
+            nits = peakNits * std::pow(scene, 1.2);
+        }
+        m_eotf[i] = float(nits / REFERENCE_WHITE_NITS);
+    }
+
+    // 映射后的线性光 -> 8位（显示伽马2.2）；下标是线性光的平方根，
+    // 线性光均匀量化时第一个非零输出就是6，暗部会出色带
+    m_oetf.resize(LUT_SIZE);
+    for (int i = 0; i < LUT_SIZE; i++) {
+        double root = i / double(LUT_SIZE - 1);
+        m_oetf[i] = int(std::lround(std::pow(root * root, 1.0 / 2.2) * 255.0));
+    }
+
+    bool fullRange = (range == AVCOL_RANGE_JPEG);
+    static const float bt2020To709[9] = {
+        1.6605f, -0.5876f, -0.0728f,
+        -0.1246f, 1.1329f, -0.0083f,
+        -0.0182f, -0.1006f, 1.1187f,
+    };
+    m_params.shift = (srcFormat == AV_PIX_FMT_P010LE) ? 6 : 0;
+    m_params.interleaved = (srcFormat == AV_PIX_FMT_P010LE);
+    m_params.yOffset = fullRange ? 0.0f : 64.0f;
+    m_params.yScale = fullRange ? 1.0f / 1023.0f : 1.0f / 876.0f;
+    m_params.chromaScale = fullRange ? 1.0f / 1023.0f : 1.0f / 896.0f;
+    for (int i = 0; i < 9; i++) {
+        m_params.gamut[i] = bt2020To709[i];
+    }
+    m_params.curve = curve;
+    if (curve == CurveHable) {
+        m_params.curveScale = 1.0f / hable(float(peak));
+    } else if (curve == CurveReinhard) {
+        m_params.curveScale = float(1.0 / (peak * peak));
+    } else {
+        m_params.curveScale = 1.0f;
+    }
+    m_params.eotf = m_eotf.constData();
+    m_params.oetf = m_oetf.constData();
+
+    // 每个像素要做几次查表和除法，比YUV转换重得多，高清起就分条
+    int bands = (height >= 720) ? qBound(1, QThread::idealThreadCount(), 16) : 1;
+    bands = qBound(1, bands, height / 64);
+    m_bandRows.clear();
+    for (int i = 0; i < bands; i++) {
+        m_bandRows.append((int)((qint64)height * i / bands) & ~1);
+    }
+    m_bandRows.append(height);
+    m_pool.setMaxThreadCount(qMax(1, bands - 1));
+
+    m_width = width;
+    m_height = height;
+    m_avx2 = YuvConverter::hasAvx2();
+    m_timing.totalNs = 0;
+    m_timing.frames = 0;
+    m_valid = true;
+
+    qDebug() << "HDR色调映射：" << (transfer == AVCOL_TRC_SMPTE2084 ? "PQ" : "HLG")
+             << "峰值" << peakNits << "nit，" << (m_avx2 ? "AVX2" : "标量") << "实现，分" << bands << "条";
+    return true;
+}
+
+void ToneMapper::release()
+{
+    m_valid = false;
+    m_eotf.clear();
+    m_oetf.clear();
+}
+
+void ToneMapper::convert(const AVFrame *frame, uint8_t *dst, int dstLinesize)
+{
+    if (!m_valid || frame->width != m_width || frame->height != m_height) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 第一条在调用线程上做，其余交给线程池
+    QVector<QFuture<void>> futures;
+    for (int i = 1; i + 1 < m_bandRows.size(); i++) {
+        int firstRow = m_bandRows.at(i);
+        int lastRow = m_bandRows.at(i + 1);
+        futures.append(QtConcurrent::run(&m_pool, [this, frame, dst, dstLinesize, firstRow, lastRow]() {
+            convertRows(frame, dst, dstLinesize, firstRow, lastRow);
+        }));
+    }
+    convertRows(frame, dst, dstLinesize, m_bandRows.at(0), m_bandRows.at(1));
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+
+    m_timing.totalNs += timer.nsecsElapsed();
+    m_timing.frames++;
+}
+
+void ToneMapper::convertRows(const AVFrame *frame, uint8_t *dst, int dstLinesize, int firstRow, int lastRow) const
+{
+    for (int row = firstRow; row < lastRow; row++) {
+        int chromaRow = row >> 1;
+        const uint16_t *y = (const uint16_t *)(frame->data[0] + (ptrdiff_t)row * frame->linesize[0]);
+        const uint16_t *u = (const uint16_t *)(frame->data[1] + (ptrdiff_t)chromaRow * frame->linesize[1]);
+        const uint16_t *v = m_params.interleaved
+                ? u + 1 : (const uint16_t *)(frame->data[2] + (ptrdiff_t)chromaRow * frame->linesize[2]);
+        uint8_t *out = dst + (ptrdiff_t)row * dstLinesize;
+
+        int x = 0;
+#ifdef TONE_HAVE_X86
+        if (m_avx2) {
+            x = tonemapRowAvx2(m_params, y, u, v, out, m_width);
+        }
+#endif
+        tonemapRowScalar(m_params, y, u, v, m_params.interleaved ? 2 : 1, out, x, m_width);
+    }
+}
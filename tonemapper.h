@@ -0,0 +1,83 @@
+#ifndef TONEMAPPER_H
+#define TONEMAPPER_H
+
+#include <QVector>
+#include <QThreadPool>
+#include "videofilter.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// HDR（PQ/HLG，BT.2020）10位画面到SDR RGB24的色调映射，不缩放。
+// 流程：YCbCr→R'G'B' → EOTF查表到线性光 → BT.2020转BT.709色域 → 压缩高光 → 伽马查表到8位
+// 按CPU选AVX2（每次8个像素，查表用gather）或标量实现，画面按行分条并行
+class ToneMapper
+{
+public:
+    enum Curve {
+        CurveHable,      // 胶片曲线，高光过渡柔和
+        CurveReinhard,   // 扩展Reinhard，峰值亮度映射到白
+        CurveClip,       // 直接截断，用来对比
+    };
+
+    ToneMapper();
+    ~ToneMapper();
+
+    // 支持的输入格式：YUV420P10LE（软解）和P010LE（硬解）
+    static bool supports(AVPixelFormat srcFormat);
+    // 传输特性是否为HDR（PQ或HLG）
+    static bool isHdr(int transfer);
+    // 名称转曲线，未知名称返回false
+    static bool curveFromName(const QString &name, Curve *curve);
+    // 帧附带的内容亮度（MaxCLL）或母版峰值亮度，都没有时返回0
+    static double framePeakNits(const AVFrame *frame);
+
+    // peakNits为母版峰值亮度（未知时用1000）
+    bool init(int width, int height, AVPixelFormat srcFormat,
+              AVColorTransferCharacteristic transfer, AVColorRange range,
+              Curve curve, double peakNits);
+    void release();
+    bool isValid() const { return m_valid; }
+    bool usesAvx2() const { return m_avx2; }
+
+    // 输出RGB24，尺寸必须和init时一致
+    void convert(const AVFrame *frame, uint8_t *dst, int dstLinesize);
+
+    // 每帧耗时统计
+    const FilterTiming &timing() const { return m_timing; }
+
+    // 查表精度（R'G'B'和映射后亮度的平方根都量化为这么多级）
+    static const int LUT_SIZE = 4096;
+
+    // 标量和AVX2共用的参数
+    struct Params {
+        int shift;               // P010数据在高10位，需右移6位
+        bool interleaved;        // P010的UV交错
+        float yOffset;
+        float yScale;
+        float chromaScale;
+        float gamut[9];          // BT.2020 -> BT.709（线性光）
+        int curve;
+        float curveScale;        // Hable：1/f(峰值)；Reinhard：1/峰值²
+        const float *eotf;       // R'G'B'码值 -> 线性光（1.0为SDR参考白）
+        const int *oetf;         // 映射后亮度的平方根 -> 8位（按线性光查表暗部只剩几级）
+    };
+
+private:
+    void convertRows(const AVFrame *frame, uint8_t *dst, int dstLinesize, int firstRow, int lastRow) const;
+
+    bool m_valid = false;
+    bool m_avx2 = false;
+    int m_width = 0;
+    int m_height = 0;
+    Params m_params = {};
+    QVector<float> m_eotf;
+    QVector<int> m_oetf;
+    QVector<int> m_bandRows;     // 各条的起始行，最后一项为总行数
+    QThreadPool m_pool;
+    FilterTiming m_timing;
+};
+
+#endif // TONEMAPPER_H
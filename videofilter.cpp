@@ -0,0 +1,258 @@
+#include "videofilter.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+VideoFilterGraph::VideoFilterGraph()
+{
+}
+
+VideoFilterGraph::~VideoFilterGraph()
+{
+    release();
+}
+
+QStringList VideoFilterGraph::splitChain(const QString &filters)
+{
+    QStringList parts;
+    QString current;
+    int depth = 0;          // 括号深度（表达式中的逗号）
+    bool quoted = false;    // 单引号内
+
+    for (int i = 0; i < filters.size(); i++) {
+        QChar c = filters.at(i);
+        if (c == '\\' && i + 1 < filters.size()) {
+            current += c;
+            current += filters.at(++i);
+            continue;
+        }
+        if (c == '\'') {
+            quoted = !quoted;
+        } else if (!quoted && c == '(') {
+            depth++;
+        } else if (!quoted && c == ')') {
+            depth = qMax(0, depth - 1);
+        } else if (!quoted && depth == 0 && c == ',') {
+            if (!current.trimmed().isEmpty()) {
+                parts.append(current.trimmed());
+            }
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    if (!current.trimmed().isEmpty()) {
+        parts.append(current.trimmed());
+    }
+    return parts;
+}
+
+bool VideoFilterGraph::init(const QString &filters, const AVFrame *frame,
+                            AVRational timeBase, int threads)
+{
+    release();
+
+    QStringList chain = splitChain(filters);
+    if (chain.isEmpty() || !frame) {
+        return false;
+    }
+
+    m_transferFrame = av_frame_alloc();
+    if (!m_transferFrame) {
+        return false;
+    }
+
+    // 逐段建立，上一段的输出参数作为下一段的输入参数
+    int width = frame->width;
+    int height = frame->height;
+    int format = frame->format;
+    AVRational sar = frame->sample_aspect_ratio;
+
+    for (const QString &desc : chain) {
+        Stage stage;
+        if (!buildStage(stage, desc, width, height, format, timeBase, sar, threads)) {
+            qDebug() << "滤镜创建失败:" << desc;
+            if (stage.graph) {
+                avfilter_graph_free(&stage.graph);
+            }
+            release();
+            return false;
+        }
+
+        width = av_buffersink_get_w(stage.sink);
+        height = av_buffersink_get_h(stage.sink);
+        format = av_buffersink_get_format(stage.sink);
+        timeBase = av_buffersink_get_time_base(stage.sink);
+        sar = av_buffersink_get_sample_aspect_ratio(stage.sink);
+        m_stages.append(stage);
+    }
+
+    m_description = filters;
+    m_outputTimeBase = timeBase;
+    qDebug() << "视频滤镜已启用:" << filters << "共" << m_stages.size() << "段，输出"
+             << width << "x" << height << av_get_pix_fmt_name((AVPixelFormat)format);
+    return true;
+}
+
+bool VideoFilterGraph::buildStage(Stage &stage, const QString &desc, int width, int height,
+                                  int format, AVRational timeBase, AVRational sar, int threads)
+{
+    stage.timing.name = desc;
+    stage.graph = avfilter_graph_alloc();
+    if (!stage.graph) {
+        return false;
+    }
+
+    // 滤镜内部按切片多线程处理（必须在添加滤镜前设置）
+    stage.graph->nb_threads = threads;
+    stage.graph->thread_type = AVFILTER_THREAD_SLICE;
+
+    if (sar.num <= 0 || sar.den <= 0) {
+        sar = av_make_q(1, 1);
+    }
+
+    char args[256];
+    snprintf(args, sizeof(args),
+             "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+             width, height, format, timeBase.num, timeBase.den, sar.num, sar.den);
+
+    int ret = avfilter_graph_create_filter(&stage.src, avfilter_get_by_name("buffer"),
+                                           "in", args, nullptr, stage.graph);
+    if (ret < 0) {
+        return false;
+    }
+
+    ret = avfilter_graph_create_filter(&stage.sink, avfilter_get_by_name("buffersink"),
+                                       "out", nullptr, nullptr, stage.graph);
+    if (ret < 0) {
+        return false;
+    }
+
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    if (!outputs || !inputs) {
+        avfilter_inout_free(&outputs);
+        avfilter_inout_free(&inputs);
+        return false;
+    }
+
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = stage.src;
+    outputs->pad_idx = 0;
+    outputs->next = nullptr;
+
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = stage.sink;
+    inputs->pad_idx = 0;
+    inputs->next = nullptr;
+
+    ret = avfilter_graph_parse_ptr(stage.graph, desc.toUtf8().constData(),
+                                   &inputs, &outputs, nullptr);
+    avfilter_inout_free(&outputs);
+    avfilter_inout_free(&inputs);
+    if (ret < 0) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        qDebug() << "解析滤镜失败:" << desc << errbuf;
+        return false;
+    }
+
+    ret = avfilter_graph_config(stage.graph, nullptr);
+    if (ret < 0) {
+        qDebug() << "配置滤镜图失败:" << desc;
+        return false;
+    }
+    return true;
+}
+
+void VideoFilterGraph::release()
+{
+    for (Stage &stage : m_stages) {
+        if (stage.graph) {
+            avfilter_graph_free(&stage.graph);
+        }
+    }
+    m_stages.clear();
+
+    if (m_transferFrame) {
+        av_frame_free(&m_transferFrame);
+    }
+    m_description.clear();
+}
+
+int VideoFilterGraph::sendFrame(AVFrame *frame)
+{
+    if (!isActive()) {
+        return AVERROR(EINVAL);
+    }
+    return pushToStage(0, frame);
+}
+
+int VideoFilterGraph::pushToStage(int index, AVFrame *frame)
+{
+    Stage &stage = m_stages[index];
+
+    QElapsedTimer timer;
+    timer.start();
+    // PUSH标志让滤镜立即处理，耗时计入本段
+    int ret = av_buffersrc_add_frame_flags(stage.src, frame, AV_BUFFERSRC_FLAG_PUSH);
+    stage.timing.totalNs += timer.nsecsElapsed();
+    stage.timing.frames++;
+    av_frame_unref(frame);
+
+    if (ret < 0 || index == m_stages.size() - 1) {
+        return ret;
+    }
+
+    // 把本段的输出全部交给下一段
+    while (true) {
+        timer.restart();
+        ret = av_buffersink_get_frame(stage.sink, m_transferFrame);
+        stage.timing.totalNs += timer.nsecsElapsed();
+        if (ret < 0) {
+            break;
+        }
+        ret = pushToStage(index + 1, m_transferFrame);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    return (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) ? 0 : ret;
+}
+
+int VideoFilterGraph::receiveFrame(AVFrame *frame)
+{
+    if (!isActive()) {
+        return AVERROR(EINVAL);
+    }
+
+    Stage &last = m_stages.last();
+    QElapsedTimer timer;
+    timer.start();
+    int ret = av_buffersink_get_frame(last.sink, frame);
+    last.timing.totalNs += timer.nsecsElapsed();
+    return ret;
+}
+
+QVector<FilterTiming> VideoFilterGraph::timings() const
+{
+    QVector<FilterTiming> result;
+    for (const Stage &stage : m_stages) {
+        result.append(stage.timing);
+    }
+    return result;
+}
+
+QString VideoFilterGraph::timingReport() const
+{
+    QStringList parts;
+    for (const Stage &stage : m_stages) {
+        parts.append(QString("%1 %2ms")
+                     .arg(stage.timing.name)
+                     .arg(stage.timing.averageMs(), 0, 'f', 2));
+    }
+    return parts.join(", ");
+}
@@ -0,0 +1,70 @@
+#ifndef VIDEOFILTER_H
+#define VIDEOFILTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+extern "C" {
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersrc.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/frame.h>
+}
+
+// 单个滤镜的耗时统计
+struct FilterTiming {
+    QString name;          // 滤镜描述（如 "yadif"）
+    qint64 totalNs = 0;    // 累计耗时（纳秒）
+    int frames = 0;        // 处理过的帧数
+
+    double averageMs() const { return frames > 0 ? totalNs / 1e6 / frames : 0.0; }
+};
+
+// 解码与渲染之间的视频滤镜阶段：buffersrc → 滤镜 → buffersink
+// 滤镜链中的每个滤镜单独成一段，便于统计每个滤镜的耗时
+class VideoFilterGraph
+{
+public:
+    VideoFilterGraph();
+    ~VideoFilterGraph();
+
+    // 按第一帧的实际参数建立滤镜图
+    bool init(const QString &filters, const AVFrame *frame,
+              AVRational timeBase, int threads);
+    void release();
+
+    bool isActive() const { return !m_stages.isEmpty(); }
+    QString description() const { return m_description; }
+    AVRational outputTimeBase() const { return m_outputTimeBase; }
+
+    // 送入一帧（接管frame中的引用，调用后frame被重置）
+    int sendFrame(AVFrame *frame);
+    // 取出一帧，AVERROR(EAGAIN)表示暂时没有输出
+    int receiveFrame(AVFrame *frame);
+
+    QVector<FilterTiming> timings() const;
+    QString timingReport() const;
+
+    // 按顶层逗号拆分滤镜链（忽略引号、括号和转义中的逗号）
+    static QStringList splitChain(const QString &filters);
+
+private:
+    struct Stage {
+        AVFilterGraph *graph = nullptr;
+        AVFilterContext *src = nullptr;
+        AVFilterContext *sink = nullptr;
+        FilterTiming timing;
+    };
+
+    bool buildStage(Stage &stage, const QString &desc, int width, int height,
+                    int format, AVRational timeBase, AVRational sar, int threads);
+    int pushToStage(int index, AVFrame *frame);
+
+    QVector<Stage> m_stages;
+    AVFrame *m_transferFrame = nullptr;    // 段与段之间传递的临时帧
+    QString m_description;
+    AVRational m_outputTimeBase = {0, 1};  // 输出帧的时间基（如yadif倍帧率会改变）
+};
+
+#endif // VIDEOFILTER_H
@@ -1,7 +1,13 @@
 #include "videothread.h"
+#include "playbackstats.h"
+#include "memorybudget.h"
+#include "playerengine.h"
 #include <QDebug>
 #include <QElapsedTimer>
 
+// 循环起点缓存至少覆盖起点之后这么长（再延长到下一个关键帧）
+static const qint64 LOOP_HEAD_MS = 2000;
+
 VideoThread::VideoThread(QObject* parent)
     : QObject(parent)
 {
@@ -10,19 +16,21 @@ VideoThread::VideoThread(QObject* parent)
     playTimer->setTimerType(Qt::PreciseTimer);  // 精确计时器
     connect(playTimer, &QTimer::timeout, this, &VideoThread::onPlayTimerTimeout);
 
+    reverseTimer = new QTimer(this);
+    reverseTimer->setTimerType(Qt::PreciseTimer);
+    connect(reverseTimer, &QTimer::timeout, this, &VideoThread::onReverseTimerTimeout);
+
     m_frameLastDelay = 0.04;  // 初始假设25fps（40ms/帧）
+    videoFilterDesc = PlayerConfig::videoFilters;
 }
 
 VideoThread::~VideoThread()
 {
-    cleanupSDL();
     cleanup();
 
-    // 销毁窗口
-    if (sdlWindow) {
-        SDL_DestroyWindow(sdlWindow);
-        sdlWindow = nullptr;
-    }
+    // 关闭输出（SDL后端同时销毁窗口）
+    delete videoRenderer;
+    videoRenderer = nullptr;
 
     SDL_Quit();
 }
@@ -30,8 +38,9 @@ VideoThread::~VideoThread()
 void VideoThread::init_video(QString currentVideoFile)
 {
 
-    cleanupSDL();
+    cleanupRender();
     cleanup();
+    resetSync();
 
     // 打开视频文件上下文
     int ret = avformat_open_input(&videoFormatCtx,
@@ -72,16 +81,21 @@ void VideoThread::init_video(QString currentVideoFile)
         return;
     }
 
-    // 9. 初始化SDL显示
-    if (!initSDLDisplay()) {
-        qDebug() <<"SDL显示初始化失败！";
+    // 9. 打开视频输出
+    if (!initRenderBackend()) {
+        qDebug() <<"视频输出初始化失败！";
         cleanup();
         return;
     }
 
+    videoGopCache.setBudget(PlayerConfig::gopCacheMB * 1024LL * 1024LL);
+    videoPacketRing.setLimits(PlayerConfig::seekBackMB * 1024LL * 1024LL,
+                              av_rescale_q(PlayerConfig::seekBackSeconds * AV_TIME_BASE, AV_TIME_BASE_Q,
+                                           videoFormatCtx->streams[videoStreamIndex]->time_base));
+
     total_time = videoFormatCtx->duration / (double)AV_TIME_BASE;
     emit UpadatseekSlider(total_time);
-    startPlayback();
+    prerollVideo();
 }
 
 //同步
@@ -91,24 +105,42 @@ void VideoThread::setAudioReference(AudioThread* audio)
     qDebug() << "视频线程现在认识音频线程了！";
 }
 
-double VideoThread::getAudioTime()
+int64_t VideoThread::currentPts() const
 {
+    return videoCurrentPts;
+}
 
-    if (m_audioRef) {
-        double audioTime = m_audioRef->getCurrentTime();
+double VideoThread::currentPosition() const
+{
+    if (!videoFormatCtx || videoStreamIndex < 0 || videoCurrentPts == AV_NOPTS_VALUE) {
+        return -1;
+    }
+    return videoCurrentPts * av_q2d(videoFormatCtx->streams[videoStreamIndex]->time_base);
+}
 
-        // 🔥 这是唯一需要改的地方：
-        static bool firstTime = true;
-        static double offset = 0;
+qint64 VideoThread::decodedFrames() const
+{
+    return videoDecodedFrames;
+}
 
-        if (firstTime && audioTime > 0) {
-            offset = audioTime;  // 记住音频的起始值
-            firstTime = false;
-            qDebug() << "🎯 音频起始偏移:" << offset << "秒 (" << offset*1000 << "ms)";
-        }
+RenderBackend* VideoThread::renderer() const
+{
+    return videoRenderer;
+}
+
+void VideoThread::resetSync()
+{
+    // 同步状态跟着文件走：换文件后重新取帧率
+    m_syncLastInterval = 0;
+    m_baseDelayForSpeed = 0;
+}
+
+double VideoThread::getAudioTime()
+{
 
-        // 返回调整后的时间（减去起始偏移）
-        return audioTime - offset;
+    // 两边预读好后同时开始，音频时钟和画面时间戳直接可比
+    if (m_audioRef) {
+        return m_audioRef->getCurrentTime();
     }
     return 0;
 
@@ -116,16 +148,46 @@ double VideoThread::getAudioTime()
 
 void VideoThread::setPlaybackSpeed(float speed)
 {
+    if (speed > 2.0f) {
+        enterFastForward(speed);
+        return;
+    }
+    if (videoFastSpeed > 0) {
+        leaveFastForward();
+    }
+
     speed = qBound(0.5f, speed, 2.0f);
     m_currentSpeed = speed;
     qDebug() << "速度改为" << speed << "x";
 
     // 如果正在播放，更新定时器间隔
-    if (GlobalVars::playerState == STATE_PLAYING  && playTimer && playTimer->isActive()) {
+    if (PlayerEngine::state() == STATE_PLAYING  && playTimer && playTimer->isActive()) {
         updateTimerInterval();
     }
 }
 
+void VideoThread::setVideoFilters(QString filters)
+{
+    videoFilterDesc = filters.trimmed();
+    // 下一帧按新描述重新建立滤镜图
+    videoFilter.release();
+    qDebug() << "视频滤镜改为:" << (videoFilterDesc.isEmpty() ? QString("无") : videoFilterDesc);
+}
+
+void VideoThread::setDisplaySize(int width, int height)
+{
+    if (width == videoDisplayWidth && height == videoDisplayHeight) {
+        return;
+    }
+    videoDisplayWidth = width;
+    videoDisplayHeight = height;
+
+    // 下一帧显示时按新尺寸重建转换器；暂停时立刻重画当前帧
+    if (PlayerEngine::state() != STATE_PLAYING && videoFrameYUV && videoFrameYUV->data[0]) {
+        displayCurrentFrame();
+    }
+}
+
 void VideoThread::updateTimerInterval()
 {
     if (!videoFormatCtx || videoStreamIndex < 0) {
@@ -147,9 +209,11 @@ void VideoThread::updateTimerInterval()
 
 void VideoThread::startPlayback()
 {
-    // 确保在文件开头
-    resetToBeginning();
+    if (!videoFormatCtx || videoStreamIndex < 0) {
+        return;
+    }
 
+    // 第一帧已经在预读时显示了，从下一帧接着走
     // 启动定时器
     AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
     double frameRate = av_q2d(videoStream->avg_frame_rate);
@@ -164,7 +228,7 @@ void VideoThread::startPlayback()
         qDebug() << "定时器启动，间隔：" << interval << "ms," << "videoStreamIndex:" <<videoStreamIndex;
     }
     emit UpadatButton(true);
-    GlobalVars::playerState = STATE_PLAYING;
+    PlayerEngine::publishState(STATE_PLAYING);
 }
 
 void VideoThread::pausePlayback()
@@ -184,15 +248,35 @@ void VideoThread::resumePlayback()
     }
 }
 
-void VideoThread::restartPlayback()
+bool VideoThread::prerollVideo()
 {
     resetToBeginning();
+    PlayerEngine::publishState(STATE_READY);
 
-    if (playTimer) {
-        playTimer->start();
+    // 读到第一帧可显示的画面为止（和定时器回调一样一包一帧）
+    for (int attempt = 0; attempt < 300; attempt++) {
+        if (readVideoPacket(videoPacket) < 0) {
+            break;
+        }
+        PlaybackStats::videoBytes.fetchAndAddRelaxed(videoPacket->size);
+        int ret = avcodec_send_packet(videoCodecCtx, videoPacket);
+        av_packet_unref(videoPacket);
+        if (ret < 0 || avcodec_receive_frame(videoCodecCtx, videoFrameYUV) < 0) {
+            continue;
+        }
+
+        rememberDecodedFrame();
+        videoCurrentPts = videoDecodePts;
+        if (!filterDecodedFrame()) {
+            continue;
+        }
+        displayCurrentFrame();
+        reportPosition(currentPosition());
+        return true;
     }
 
-    GlobalVars::playerState = STATE_PLAYING;
+    qDebug() << "预读：没有解出第一帧";
+    return false;
 }
 
 void VideoThread::onPlayFinished()
@@ -207,11 +291,16 @@ void VideoThread::resetToBeginning()
 {
     if (videoFormatCtx && videoStreamIndex >= 0) {
         av_seek_frame(videoFormatCtx, videoStreamIndex, 0, AVSEEK_FLAG_BACKWARD);
+        videoPacketRing.clear();
         qDebug() << "重置到视频开头";
         if (videoCodecCtx) {
             qDebug() << "重置!";
             avcodec_flush_buffers(videoCodecCtx);
         }
+        videoFilter.release();
+        videoGopCache.clear();
+        videoCurrentPts = AV_NOPTS_VALUE;
+        videoDecodePts = AV_NOPTS_VALUE;
     }
 }
 
@@ -260,6 +349,13 @@ bool VideoThread::initVideoDecoder()
         return false;
     }
 
+    // 低分辨率解码（只有部分解码器支持，如mjpeg/jpeg2000/h263系）
+    int lowres = chooseLowres(codec);
+    if (lowres > 0) {
+        videoCodecCtx->lowres = lowres;
+        qDebug() << "低分辨率解码：1/" << (1 << lowres);
+    }
+
     // 5. 打开解码器
     ret = avcodec_open2(videoCodecCtx, codec, NULL);
     if (ret < 0) {
@@ -278,63 +374,11 @@ bool VideoThread::initVideoDecoder()
         return false;
     }
 
-    // 7. 创建RGB帧（显示用）
-    videoFrameRGB = av_frame_alloc();
-    if (!videoFrameRGB) {
-        qDebug() << "错误：无法分配RGB帧";
-        av_frame_free(&videoFrameYUV);
-        avcodec_free_context(&videoCodecCtx);
-        return false;
-    }
+    // 7. 颜色转换器和RGB缓冲在显示第一帧时按帧的实际参数创建（见ConversionCache）
+    videoConversions.clear();
+    videoConversion = nullptr;
 
-    // 8. 为RGB帧分配内存
-    int bufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGB24,
-                                              videoCodecCtx->width,
-                                              videoCodecCtx->height, 1);
-    uint8_t* buffer = (uint8_t*)av_malloc(bufferSize);
-    if (!buffer) {
-        qDebug() << "错误：无法为RGB帧分配内存";
-        av_frame_free(&videoFrameRGB);
-        av_frame_free(&videoFrameYUV);
-        avcodec_free_context(&videoCodecCtx);
-        return false;
-    }
-
-    // 9. 设置RGB帧参数并关联内存
-    ret = av_image_fill_arrays(videoFrameRGB->data, videoFrameRGB->linesize,
-                               buffer, AV_PIX_FMT_RGB24,
-                               videoCodecCtx->width, videoCodecCtx->height, 1);
-    if (ret < 0) {
-        qDebug() << "错误：无法填充RGB帧数组";
-        av_freep(&buffer);
-        av_frame_free(&videoFrameRGB);
-        av_frame_free(&videoFrameYUV);
-        avcodec_free_context(&videoCodecCtx);
-        return false;
-    }
-
-    // 设置RGB帧的宽度和高度
-    videoFrameRGB->width = videoCodecCtx->width;
-    videoFrameRGB->height = videoCodecCtx->height;
-    videoFrameRGB->format = AV_PIX_FMT_RGB24;
-
-    // 10. 创建颜色空间转换器（YUV -> RGB）
-    videoSwsCtx = sws_getContext(
-                videoCodecCtx->width, videoCodecCtx->height, videoCodecCtx->pix_fmt,
-                videoCodecCtx->width, videoCodecCtx->height, AV_PIX_FMT_RGB24,
-                SWS_BILINEAR, NULL, NULL, NULL
-                );
-
-    if (!videoSwsCtx) {
-        qDebug() << "错误：无法创建图像缩放转换器";
-        av_freep(&buffer);
-        av_frame_free(&videoFrameRGB);
-        av_frame_free(&videoFrameYUV);
-        avcodec_free_context(&videoCodecCtx);
-        return false;
-    }
-
-    // 11. 创建数据包
+    // 8. 创建数据包
     videoPacket = av_packet_alloc();
 
     av_read_frame(videoFormatCtx, videoPacket);
@@ -351,9 +395,6 @@ bool VideoThread::initVideoDecoder()
 
     if (!videoPacket) {
         qDebug() << "错误：无法分配数据包";
-        sws_freeContext(videoSwsCtx);
-        av_freep(&buffer);
-        av_frame_free(&videoFrameRGB);
         av_frame_free(&videoFrameYUV);
         avcodec_free_context(&videoCodecCtx);
         return false;
@@ -368,72 +409,26 @@ bool VideoThread::initVideoDecoder()
     return true;
 }
 
-bool VideoThread::initSDLDisplay()
+bool VideoThread::initRenderBackend()
 {
-    qDebug() << "开始初始化SDL显示...";
-
-    //缺少：初始化SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        qDebug() << "SDL初始化失败:" << SDL_GetError();
+    // 没有显示窗口时（如离屏运行）在这里创建后端
+    if (!videoRenderer) {
+        videoRenderer = RenderBackend::create(PlayerConfig::renderBackend, m_displayWidget);
+    }
+    if (!videoRenderer) {
         return false;
     }
 
-    // 2. 检查是否有视频解码器信息
     if (!videoCodecCtx) {
         qDebug() << "错误：视频解码器未初始化";
         return false;
     }
 
-    // 3. 获取Qt视频显示部件的窗口ID
-    if (!widgetId) {
-        qDebug() << "错误：无法获取Qt视频部件的窗口ID";
+    if (!videoRenderer->open()) {
+        qDebug() << "错误：" << videoRenderer->name() << "输出打开失败";
         return false;
     }
-
-    qDebug() << "Qt视频部件窗口ID：" << widgetId;
-
-    // 4. 创建SDL窗口（嵌入到Qt窗口中）
-    sdlWindow = SDL_CreateWindowFrom((void*)widgetId);
-    if (!sdlWindow) {
-        qDebug() << "错误：创建SDL窗口失败：" << SDL_GetError();
-        return false;
-    }
-
-    // 5. 创建SDL渲染器
-    // 尝试使用硬件加速渲染器
-    sdlRenderer = SDL_CreateRenderer(sdlWindow, -1,
-                                     SDL_RENDERER_ACCELERATED |
-                                     SDL_RENDERER_PRESENTVSYNC);
-
-    // 如果硬件加速失败，尝试软件渲染器
-    if (!sdlRenderer) {
-        qDebug() << "硬件加速渲染器创建失败，尝试软件渲染：" << SDL_GetError();
-        sdlRenderer = SDL_CreateRenderer(sdlWindow, -1, SDL_RENDERER_SOFTWARE);
-    }
-
-    if (!sdlRenderer) {
-        qDebug() << "错误：创建SDL渲染器失败：" << SDL_GetError();
-        //    cleanupSDL();
-        return false;
-    }
-
-    qDebug() << "✅ SDL渲染器创建成功";
-
-    // 6. 设置渲染器属性
-    SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);  // 黑色背景
-    SDL_RenderClear(sdlRenderer);
-    SDL_RenderPresent(sdlRenderer);
-
-    // 设置纹理缩放质量
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-
-    // 7. 获取渲染器信息用于调试
-    SDL_RendererInfo rendererInfo;
-    SDL_GetRendererInfo(sdlRenderer, &rendererInfo);
-
-    // 8. 检查渲染器是否支持需要的功能
-    bool hasAcceleration = (rendererInfo.flags & SDL_RENDERER_ACCELERATED) != 0;
-    bool hasVSync = (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+    qDebug() << "视频输出后端：" << videoRenderer->name();
     return true;
 }
 
@@ -442,7 +437,13 @@ void VideoThread::setDisplayWidget(QWidget *widget)
     m_displayWidget = widget;
     if (widget) {
         widgetId= widget->winId();
+        videoDisplayWidth = static_cast<int>(widget->width() * widget->devicePixelRatioF());
+        videoDisplayHeight = static_cast<int>(widget->height() * widget->devicePixelRatioF());
         qDebug() << "设置显示窗口，句柄：" << widgetId;
+
+        // 在界面线程创建输出后端（Qt后端要在部件上安装事件过滤器）
+        delete videoRenderer;
+        videoRenderer = RenderBackend::create(PlayerConfig::renderBackend, widget);
     }
 }
 
@@ -583,7 +584,7 @@ QString VideoThread::formatTime(qint64 seconds)
 void VideoThread::onPlayTimerTimeout()
 {
     // 检查状态
-    if (GlobalVars::playerState != STATE_PLAYING) {
+    if (PlayerEngine::state() != STATE_PLAYING) {
         return;
     }
 
@@ -593,34 +594,36 @@ void VideoThread::onPlayTimerTimeout()
         return;
     }
 
+    if (videoFastSpeed > 0) {
+        fastForwardTick();
+        return;
+    }
+
+    // 滤镜里还有未取出的帧（如yadif=1倍帧率输出），先显示它
+    // （videoFrameYUV还引用着上一帧，buffersink不会先释放它）
+    if (videoFilter.isActive()) {
+        av_frame_unref(videoFrameYUV);
+        if (videoFilter.receiveFrame(videoFrameYUV) >= 0) {
+            presentDecodedFrame();
+            return;
+        }
+    }
+
     // 最多尝试3个数据包（防止卡住）
     for (int attempt = 0; attempt < 3; attempt++) {
         // 1. 读取一个数据包
-        int ret = av_read_frame(videoFormatCtx, videoPacket);
+        int ret = readVideoPacket(videoPacket);
         if (ret < 0) {
             if (ret == AVERROR_EOF) {
-                qDebug() << "视频播放结束！";
-
-
-                int totalMin = (int)total_time / 60;
-                int totalSec = (int)total_time % 60;
-
-                QString timeText = QString("%1:%2 / %3:%4")
-                        .arg(totalMin, 2, 10, QChar('0'))
-                        .arg(totalSec, 2, 10, QChar('0'))
-                        .arg(totalMin, 2, 10, QChar('0'))
-                        .arg(totalSec, 2, 10, QChar('0'));
-                emit UpadatStatus(timeText,total_time  * 1000);
-                emit UpadatButton(false);
-                GlobalVars::playerState = STATE_ENDED;
-                playTimer->stop();
-
+                finishPlayback();
             }
             return;
         }
 
         // 2. 检查是否是视频包
         if (videoPacket->stream_index == videoStreamIndex) {
+            PlaybackStats::videoBytes.fetchAndAddRelaxed(videoPacket->size);
+
             // 3. 发送给解码器
             ret = avcodec_send_packet(videoCodecCtx, videoPacket);
             av_packet_unref(videoPacket);
@@ -632,103 +635,284 @@ void VideoThread::onPlayTimerTimeout()
             // 4. 接收解码后的帧
             ret = avcodec_receive_frame(videoCodecCtx, videoFrameYUV);
             if (ret >= 0) {
+                rememberDecodedFrame();
 
-                AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
-                double currentTime = 0;
-
+                // A-B循环：解到终点就回起点，终点这一帧不显示
+                if (videoLoopStartMs >= 0 && videoLoopEndMs >= 0 && videoDecodePts != AV_NOPTS_VALUE &&
+                    videoDecodePts * av_q2d(videoFormatCtx->streams[videoStreamIndex]->time_base) * 1000
+                        >= videoLoopEndMs) {
+                    wrapLoop();
+                    return;
+                }
+                videoCurrentPts = videoDecodePts;
 
-                if (videoFrameYUV->pts != AV_NOPTS_VALUE) {
-                    currentTime = videoFrameYUV->pts * av_q2d(videoStream->time_base);
+                // 5. 经过滤镜（滤镜需要更多输入时继续读包）
+                if (!filterDecodedFrame()) {
+                    continue;
                 }
 
-                else {
-                    static int frameCount = 0;
-                    frameCount++;
-                    double fps = av_q2d(videoStream->avg_frame_rate);
-                    if (fps > 0) {
-                        currentTime = frameCount / fps;
-                    }
+                if (presentDecodedFrame()) {
+                    return;
                 }
+            }
+        } else {
+            av_packet_unref(videoPacket);
+        }
+    }
+}
 
+void VideoThread::finishPlayback()
+{
+    if (videoLoopStartMs >= 0) {
+        wrapLoop();
+        return;
+    }
 
-                if (currentTime> 0) {
-                    // 🔥 获取音频时间
-                    double audioTime = getAudioTime();
+    qDebug() << "视频播放结束！";
 
-                    // 🔥 应用起始偏移补偿（只在前几帧）
-                    static double compensation = 0;
-                    static int frameCount = 0;
-                    frameCount++;
+    reportPosition(total_time);
+    emit UpadatButton(false);
+    PlayerEngine::publishState(STATE_ENDED);
+    playTimer->stop();
+}
 
-                    if (frameCount <= 5 && audioTime > currentTime) {
-                        static double totalDiff = 0;
-                        totalDiff += (audioTime - currentTime);
-                        compensation = totalDiff / frameCount;
+// 快进：4x只解参考帧，8x/16x只解关键帧（非关键帧的包直接不送解码器），
+// 显示频率降到24/12fps，解码量大致不随倍速增长
+void VideoThread::enterFastForward(float speed)
+{
+    speed = qBound(4.0f, speed, 16.0f);
+    if (!videoCodecCtx) {
+        return;
+    }
 
-                        if (frameCount == 5) {
-                            qDebug() << "🎯 最终补偿值:" << compensation * 1000 << "ms";
-                        }
-                    }
+    if (videoFastSpeed <= 0) {
+        AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+        videoFastClock = (videoCurrentPts != AV_NOPTS_VALUE)
+                ? videoCurrentPts * av_q2d(videoStream->time_base) : 0.0;
+        // 跳帧后帧不再连续，逐帧缓存先不用
+        videoGopCache.clear();
+    }
+    videoFastSpeed = speed;
+    videoCodecCtx->skip_frame = (speed >= 8.0f) ? AVDISCARD_NONKEY : AVDISCARD_NONREF;
+    videoFastWall.start();
 
-                    // 应用补偿
-                    double adjustedPts = currentTime + compensation;
+    int presentFps = (speed >= 8.0f) ? 12 : 24;
+    if (playTimer) {
+        playTimer->setInterval(1000 / presentFps);
+    }
+    qDebug() << "快进" << speed << "x，"
+             << (speed >= 8.0f ? "只解关键帧" : "跳过非参考帧") << "，显示" << presentFps << "fps";
+}
 
-                    // 🔥 同步计算
-                    double delay = synchronizeVideo(adjustedPts);
+void VideoThread::leaveFastForward()
+{
+    videoFastSpeed = 0;
+    videoFastPending = false;
+    if (!videoCodecCtx) {
+        return;
+    }
+    videoCodecCtx->skip_frame = AVDISCARD_DEFAULT;
+
+    // 跳过的帧让解码器的参考状态不完整，从当前位置重新精确定位
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    double position = (videoCurrentPts != AV_NOPTS_VALUE)
+            ? videoCurrentPts * av_q2d(videoStream->time_base) : videoFastClock;
+    qint64 positionMs = static_cast<qint64>(position * 1000);
+    decodeUntilTarget(static_cast<int>(positionMs), true);
+    if (PlayerEngine::state() == STATE_PLAYING) {
+        updateTimerInterval();
+    }
 
-                    // 🔥 更新定时器间隔
-                    if (playTimer) {
-                        int interval = static_cast<int>(delay * 1000);
-                        interval = qBound(10, interval, 100);
+    qDebug() << "快进结束，位置" << positionMs << "ms";
+    emit fastForwardFinished(positionMs);
+}
 
-                        static int lastInterval = 0;
-                        if (qAbs(interval - lastInterval) > 2) {  // 变化超过2ms才更新
-                            playTimer->setInterval(interval);
-                            lastInterval = interval;
-                        }
+void VideoThread::fastForwardTick()
+{
+    // 暂停过的话不要一下子跳过去
+    double elapsed = qMin(videoFastWall.restart() / 1000.0, 0.2);
+    videoFastClock += elapsed * videoFastSpeed;
+
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    bool keyOnly = (videoCodecCtx->skip_frame == AVDISCARD_NONKEY);
+    // 比时钟落后超过一次显示间隔的帧直接丢掉
+    double tolerance = playTimer->interval() / 1000.0 * videoFastSpeed;
+
+    for (int attempt = 0; attempt < 200; attempt++) {
+        if (!videoFastPending) {
+            int ret = avcodec_receive_frame(videoCodecCtx, videoFrameYUV);
+            if (ret == AVERROR(EAGAIN)) {
+                ret = readVideoPacket(videoPacket);
+                if (ret < 0) {
+                    if (ret == AVERROR_EOF) {
+                        finishPlayback();
                     }
+                    return;
+                }
+                if (videoPacket->stream_index == videoStreamIndex &&
+                        (!keyOnly || (videoPacket->flags & AV_PKT_FLAG_KEY))) {
+                    PlaybackStats::videoBytes.fetchAndAddRelaxed(videoPacket->size);
+                    avcodec_send_packet(videoCodecCtx, videoPacket);
+                }
+                av_packet_unref(videoPacket);
+                continue;
+            }
+            if (ret < 0) {
+                return;
+            }
+            videoFastPending = true;
+        }
 
-                    // 显示帧
-                    displayCurrentFrame();
+        int64_t pts = (videoFrameYUV->best_effort_timestamp != AV_NOPTS_VALUE)
+                ? videoFrameYUV->best_effort_timestamp : videoFrameYUV->pts;
+        double frameTime = (pts != AV_NOPTS_VALUE) ? pts * av_q2d(videoStream->time_base) : videoFastClock;
+        if (frameTime > videoFastClock) {
+            // 还没到显示时间（关键帧稀疏时常见），留到下一次
+            return;
+        }
+        videoFastPending = false;
+
+        if (frameTime < videoFastClock - tolerance) {
+            // 落后太多说明解码跟不上，时钟退回来，避免一直追
+            if (videoFastClock - frameTime > 2.0 * videoFastSpeed) {
+                videoFastClock = frameTime;
+            } else {
+                PlaybackStats::droppedFrames.fetchAndAddRelaxed(1);
+                av_frame_unref(videoFrameYUV);
+                continue;
+            }
+        }
 
-                    //    emit UpadatStatus(formatTime(audioTime), audioTime * 1000);
+        videoCurrentPts = pts;
+        videoDecodePts = pts;
+        filterDecodedFrame(true);
+        displayCurrentFrame();
+        reportPosition(frameTime);
+        return;
+    }
+}
 
-                    int currentMin = (int)currentTime / 60;
-                    int currentSec = (int)currentTime % 60;
-                    int totalMin = (int)total_time / 60;
-                    int totalSec = (int)total_time % 60;
+bool VideoThread::presentDecodedFrame()
+{
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    // 滤镜可能改变时间基（如倍帧率去隔行）
+    AVRational timeBase = videoFilter.isActive() ? videoFilter.outputTimeBase()
+                                                 : videoStream->time_base;
+    double currentTime = 0;
 
-                    QString timeText = QString("%1:%2 / %3:%4")
-                            .arg(currentMin, 2, 10, QChar('0'))
-                            .arg(currentSec, 2, 10, QChar('0'))
-                            .arg(totalMin, 2, 10, QChar('0'))
-                            .arg(totalSec, 2, 10, QChar('0'));
 
-                    emit UpadatStatus(timeText,currentTime  * 1000);
+    if (videoFrameYUV->pts != AV_NOPTS_VALUE) {
+        currentTime = videoFrameYUV->pts * av_q2d(timeBase);
+    }
 
-                    return;
-                }
-            }
-        } else {
-            av_packet_unref(videoPacket);
+    else {
+        static int frameCount = 0;
+        frameCount++;
+        double fps = av_q2d(videoStream->avg_frame_rate);
+        if (fps > 0) {
+            currentTime = frameCount / fps;
         }
     }
+
+
+    if (currentTime <= 0) {
+        PlaybackStats::droppedFrames.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    // 🔥 获取音频时间
+    double audioTime = getAudioTime();
+
+    // 🔥 同步计算
+    double delay = synchronizeVideo(currentTime);
+
+    // 统计：画面相对声音的偏差，晚了一帧以上记一次
+    if (m_audioRef) {
+        double avDiff = currentTime - audioTime;
+        PlaybackStats::avDiffUs.storeRelease(static_cast<qint64>(avDiff * 1000000));
+        if (avDiff < -m_baseDelayForSpeed) {
+            PlaybackStats::lateFrames.fetchAndAddRelaxed(1);
+        }
+    }
+
+    // 🔥 更新定时器间隔
+    if (playTimer) {
+        int interval = static_cast<int>(delay * 1000);
+        interval = qBound(10, interval, 100);
+
+        if (qAbs(interval - m_syncLastInterval) > 2) {  // 变化超过2ms才更新
+            playTimer->setInterval(interval);
+            m_syncLastInterval = interval;
+        }
+    }
+
+    // 显示帧
+    displayCurrentFrame();
+
+    reportPosition(currentTime);
+    return true;
+}
+
+void VideoThread::reportPosition(double currentTime)
+{
+    // 只写原子量，界面按刷新率自己来读（每帧发带字符串的信号太多了）
+    PlaybackStats::positionMs.storeRelease(static_cast<qint64>(currentTime * 1000));
 }
 
-void VideoThread::cleanupSDL()
+bool VideoThread::filterDecodedFrame(bool fallbackToSource)
 {
-    // 1. 销毁纹理
-    if (sdlTexture) {
-        SDL_DestroyTexture(sdlTexture);
-        sdlTexture = nullptr;
-        qDebug() << "SDL纹理已销毁";
+    if (videoFilterDesc.isEmpty()) {
+        return true;
+    }
+
+    // 按第一帧的实际尺寸/格式建立滤镜图
+    if (!videoFilter.isActive()) {
+        AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+        if (!videoFilter.init(videoFilterDesc, videoFrameYUV,
+                              videoStream->time_base, PlayerConfig::filterThreads)) {
+            qDebug() << "视频滤镜初始化失败，已关闭滤镜：" << videoFilterDesc;
+            videoFilterDesc.clear();
+            return true;
+        }
     }
 
-    // 2. 销毁渲染器
-    if (sdlRenderer) {
-        SDL_DestroyRenderer(sdlRenderer);
-        sdlRenderer = nullptr;
-        qDebug() << "SDL渲染器已销毁";
+    if (fallbackToSource) {
+        if (!videoFrameBackup) {
+            videoFrameBackup = av_frame_alloc();
+        }
+        if (videoFrameBackup) {
+            av_frame_ref(videoFrameBackup, videoFrameYUV);
+        }
+    }
+
+    int ret = videoFilter.sendFrame(videoFrameYUV);
+    if (ret >= 0) {
+        ret = videoFilter.receiveFrame(videoFrameYUV);
+    }
+
+    if (videoFrameBackup) {
+        if (ret < 0 && fallbackToSource && videoFrameBackup->buf[0]) {
+            // 滤镜还需要后续帧（如yadif），预览先显示原始帧
+            av_frame_move_ref(videoFrameYUV, videoFrameBackup);
+            return true;
+        }
+        av_frame_unref(videoFrameBackup);
+    }
+
+    if (ret < 0) {
+        return false;
+    }
+
+    if (++videoFilteredFrames % 250 == 0) {
+        qDebug() << "滤镜平均耗时:" << videoFilter.timingReport();
+    }
+    return true;
+}
+
+void VideoThread::cleanupRender()
+{
+    if (videoRenderer) {
+        videoRenderer->close();
     }
 }
 
@@ -740,21 +924,26 @@ void VideoThread::cleanup()
         playTimer->stop();
         qDebug() << "定时器已停止";
     }
+    stopReverse(false);
 
     // 清理视频资源（按创建的反顺序）
-    if (videoSwsCtx) {
-        sws_freeContext(videoSwsCtx);
-        videoSwsCtx = nullptr;
-    }
-
-    if (videoFrameRGB) {
-        av_frame_free(&videoFrameRGB);
-    }
+    videoConversions.clear();
+    videoConversion = nullptr;
 
     if (videoFrameYUV) {
         av_frame_free(&videoFrameYUV);
     }
 
+    videoFilter.release();
+    if (videoFrameBackup) {
+        av_frame_free(&videoFrameBackup);
+    }
+    videoGopCache.clear();
+    videoPacketRing.clear();
+    clearLoopHead();
+    videoCurrentPts = AV_NOPTS_VALUE;
+    videoDecodePts = AV_NOPTS_VALUE;
+
     if (videoPacket) {
         av_packet_free(&videoPacket);
     }
@@ -768,41 +957,13 @@ void VideoThread::cleanup()
     }
 
     // 重置状态
-    GlobalVars::playerState = STATE_IDLE;
+    PlayerEngine::publishState(STATE_IDLE);
     videoStreamIndex = -1;
     VideoFile.clear();
 
     qDebug() << "资源清理完成";
 }
 
-void VideoThread::UpadatStatus()
-{
-    switch (GlobalVars::playerState) {
-    case STATE_IDLE:
-        // 还没打开文件，先打开
-        //           if (openVideoFile()) {
-        //               startPlayback();
-        //           }
-        break;
-
-    case STATE_READY:
-        startPlayback();
-        break;
-
-    case STATE_PLAYING:
-        resumePlayback();
-        break;
-
-    case STATE_PAUSED:
-        pausePlayback();
-        break;
-
-    case STATE_ENDED:
-        restartPlayback();
-        break;
-    }
-}
-
 void VideoThread::setSeekSlider(int flog,int value)
 {
     if(0 == flog)
@@ -845,6 +1006,335 @@ void VideoThread::toSeek(int value)
     decodeUntilTarget(value, true);
 }
 
+void VideoThread::stepFrame(int direction)
+{
+    if (!videoFormatCtx || !videoCodecCtx || videoStreamIndex < 0) {
+        return;
+    }
+    pausePlayback();
+
+    if (videoCurrentPts == AV_NOPTS_VALUE) {
+        qDebug() << "逐帧：当前没有显示的帧";
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int64_t pts = AV_NOPTS_VALUE;
+    const AVFrame* frame = nullptr;
+    if (direction < 0) {
+        frame = videoGopCache.before(videoCurrentPts, &pts);
+        if (!frame) {
+            // 缓存里没有上一帧：从前一个关键帧解码到当前帧，整组放进缓存
+            decodeForStep(videoCurrentPts - 1, videoCurrentPts);
+            frame = videoGopCache.before(videoCurrentPts, &pts);
+        }
+    } else {
+        frame = videoGopCache.after(videoCurrentPts, &pts);
+        if (!frame) {
+            // 后退过且后面的帧已被淘汰时，解码器位置在当前帧之后，需要重新定位
+            bool reseek = (videoDecodePts != AV_NOPTS_VALUE && videoDecodePts > videoCurrentPts);
+            decodeForStep(reseek ? videoCurrentPts : AV_NOPTS_VALUE, videoCurrentPts + 1);
+            frame = videoGopCache.after(videoCurrentPts, &pts);
+        }
+    }
+
+    if (!frame) {
+        qDebug() << (direction < 0 ? "逐帧：已经是第一帧" : "逐帧：已经是最后一帧");
+        return;
+    }
+
+    showStepFrame(frame, pts);
+    qDebug() << "逐帧" << direction << "用时" << timer.elapsed() << "ms，缓存"
+             << videoGopCache.size() << "帧" << videoGopCache.memoryUsed() / (1024 * 1024) << "MB";
+}
+
+int VideoThread::readVideoPacket(AVPacket* packet)
+{
+    if (videoPacketRing.next(packet)) {
+        captureLoopHead(packet);
+        return 0;
+    }
+
+    // 回放追上后接着读文件，读到的视频包记进缓冲（其它流的包直接丢掉）
+    while (true) {
+        int ret = av_read_frame(videoFormatCtx, packet);
+        if (ret < 0) {
+            return ret;
+        }
+        if (packet->stream_index == videoStreamIndex) {
+            videoPacketRing.append(packet);
+            captureLoopHead(packet);
+            return 0;
+        }
+        av_packet_unref(packet);
+    }
+}
+
+void VideoThread::setLoop(qint64 startMs, qint64 endMs)
+{
+    if (startMs != videoLoopStartMs) {
+        clearLoopHead();
+    }
+    videoLoopStartMs = startMs;
+    videoLoopEndMs = (startMs >= 0 && endMs > startMs) ? endMs : -1;
+    qDebug() << "循环区间：" << videoLoopStartMs << "~" << videoLoopEndMs << "ms";
+}
+
+// 回到循环起点：整段循环还在回看缓冲里时直接从内存回放（文件读位置不动）；
+// 否则把存好的起点包放进缓冲回放，文件只跳到这段包之后（按关键帧定位），
+// 解码器不用等读盘就能出起点的画面；两样都没有时按普通跳转处理
+void VideoThread::wrapLoop()
+{
+    if (!videoFormatCtx || !videoCodecCtx) {
+        return;
+    }
+
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    int64_t startPts = loopStartPts();
+
+    QElapsedTimer timer;
+    timer.start();
+    bool fromRing = videoPacketRing.rewindTo(startPts);
+    if (!fromRing && videoLoopHeadEnd != AV_NOPTS_VALUE &&
+        av_seek_frame(videoFormatCtx, videoStreamIndex, videoLoopHeadEnd, AVSEEK_FLAG_BACKWARD) >= 0) {
+        videoPacketRing.replay(videoLoopHead);
+    }
+
+    bool wasPlaying = playTimer && playTimer->isActive();
+    decodeUntilTarget(static_cast<int>(startPts * av_q2d(videoStream->time_base) * 1000), true);
+    if (wasPlaying) {
+        playTimer->start();
+    }
+    qDebug() << "循环回到起点，用时" << timer.elapsed() << "ms"
+             << (fromRing ? "（回看缓冲）" : (videoLoopHeadEnd != AV_NOPTS_VALUE ? "（起点缓存）" : ""));
+}
+
+void VideoThread::captureLoopHead(const AVPacket* packet)
+{
+    // 没开循环或已经存好
+    if (videoLoopStartMs < 0 || videoLoopHeadEnd != AV_NOPTS_VALUE) {
+        return;
+    }
+
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    int64_t startPts = loopStartPts();
+    bool key = (packet->flags & AV_PKT_FLAG_KEY) && packet->pts != AV_NOPTS_VALUE;
+
+    if (key && packet->pts <= startPts) {
+        // 起点之前最近的关键帧，从这里重新开始存
+        clearLoopHead();
+    } else if (videoLoopHead.isEmpty()) {
+        return;
+    } else if (key && packet->pts - startPts >
+               av_rescale_q(LOOP_HEAD_MS, AVRational{1, 1000}, videoStream->time_base)) {
+        // 起点之后存够一段，在关键帧处截断，回放完从这里接着读文件
+        videoLoopHeadEnd = packet->pts;
+        qDebug() << "循环起点缓存" << videoLoopHead.size() << "个包";
+        return;
+    }
+
+    AVPacket* copy = videoLoopHeadPool.ref(packet);
+    if (copy) {
+        videoLoopHead.append(copy);
+        MemoryBudget::charge(MemoryBudget::LoopHead, copy->size);
+    }
+}
+
+int64_t VideoThread::loopStartPts() const
+{
+    // 文件开头的pts可能不是0（如TS），起点不早于第一帧
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    int64_t startPts = av_rescale_q(videoLoopStartMs, AVRational{1, 1000}, videoStream->time_base);
+    if (videoStream->start_time != AV_NOPTS_VALUE) {
+        startPts = qMax(startPts, videoStream->start_time);
+    }
+    return startPts;
+}
+
+void VideoThread::clearLoopHead()
+{
+    for (AVPacket* packet : videoLoopHead) {
+        MemoryBudget::charge(MemoryBudget::LoopHead, -packet->size);
+        videoLoopHeadPool.release(packet);
+    }
+    videoLoopHead.clear();
+    videoLoopHeadEnd = AV_NOPTS_VALUE;
+}
+
+void VideoThread::rememberDecodedFrame()
+{
+    videoDecodedFrames++;
+    PlaybackStats::decodedFrames.fetchAndAddRelaxed(1);
+    int64_t pts = videoFrameYUV->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        pts = videoFrameYUV->pts;
+    }
+    if (pts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    videoDecodePts = pts;
+    if (videoFastSpeed <= 0) {
+        videoGopCache.insert(videoFrameYUV, pts);
+        PlaybackStats::frameCacheFrames.storeRelease(videoGopCache.size());
+    }
+}
+
+// seekPts为AV_NOPTS_VALUE时从解码器当前位置继续，解码到pts>=stopPts的帧为止
+bool VideoThread::decodeForStep(int64_t seekPts, int64_t stopPts)
+{
+    if (seekPts != AV_NOPTS_VALUE) {
+        if (av_seek_frame(videoFormatCtx, videoStreamIndex, seekPts, AVSEEK_FLAG_BACKWARD) < 0) {
+            qDebug() << "逐帧：跳转失败";
+            return false;
+        }
+        videoPacketRing.clear();
+        avcodec_flush_buffers(videoCodecCtx);
+        videoDecodePts = AV_NOPTS_VALUE;
+    }
+
+    bool draining = false;
+    while (true) {
+        int ret = avcodec_receive_frame(videoCodecCtx, videoFrameYUV);
+        if (ret >= 0) {
+            rememberDecodedFrame();
+            av_frame_unref(videoFrameYUV);
+            if (videoDecodePts != AV_NOPTS_VALUE && videoDecodePts >= stopPts) {
+                return true;
+            }
+            continue;
+        }
+        if (ret == AVERROR_EOF || draining) {
+            return false;
+        }
+
+        ret = readVideoPacket(videoPacket);
+        if (ret < 0) {
+            // 文件末尾，取出解码器里剩下的帧
+            avcodec_send_packet(videoCodecCtx, nullptr);
+            draining = true;
+            continue;
+        }
+        if (videoPacket->stream_index == videoStreamIndex) {
+            avcodec_send_packet(videoCodecCtx, videoPacket);
+        }
+        av_packet_unref(videoPacket);
+    }
+}
+
+void VideoThread::showStepFrame(const AVFrame* frame, int64_t pts)
+{
+    av_frame_unref(videoFrameYUV);
+    if (av_frame_ref(videoFrameYUV, frame) < 0) {
+        return;
+    }
+    videoCurrentPts = pts;
+
+    // 帧顺序不再连续，滤镜按单帧重新建立
+    videoFilter.release();
+    filterDecodedFrame(true);
+    displayCurrentFrame();
+
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    reportPosition(pts * av_q2d(videoStream->time_base));
+}
+
+void VideoThread::setReversePlayback(float speed)
+{
+    if (speed <= 0) {
+        stopReverse(true);
+        return;
+    }
+    if (!videoFormatCtx || !videoCodecCtx || videoStreamIndex < 0) {
+        return;
+    }
+    pausePlayback();
+
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    if (!videoReverse.isActive()) {
+        // 没有显示过帧（如播放结束后）从文件末尾开始
+        int64_t fromPts = videoCurrentPts;
+        if (fromPts == AV_NOPTS_VALUE) {
+            fromPts = av_rescale_q(videoFormatCtx->duration, av_get_time_base_q(), videoStream->time_base);
+        }
+        if (!videoReverse.start(VideoFile, videoStreamIndex, fromPts,
+                                PlayerConfig::reverseCacheMB * 1024LL * 1024LL)) {
+            qDebug() << "倒放启动失败";
+            emit reverseFinished();
+            return;
+        }
+    }
+
+    // 显示频率最高60fps，更高的倍速靠跳帧
+    double frameRate = av_q2d(videoStream->avg_frame_rate);
+    if (frameRate <= 0) frameRate = 30.0;
+    double presentRate = qMin(frameRate * speed, 60.0);
+    videoReverseFramesPerTick = qMax(1, qRound(frameRate * speed / presentRate));
+
+    int interval = qMax(1, static_cast<int>(1000 / presentRate));
+    reverseTimer->start(interval);
+    qDebug() << "倒放速度" << speed << "x，间隔" << interval << "ms，每次" << videoReverseFramesPerTick << "帧";
+}
+
+void VideoThread::onReverseTimerTimeout()
+{
+    AVFrame* frame = nullptr;
+    bool finished = false;
+
+    for (int i = 0; i < videoReverseFramesPerTick; i++) {
+        AVFrame* next = videoReverse.takeFrame(&finished);
+        if (!next) {
+            break;
+        }
+        av_frame_free(&frame);
+        frame = next;
+    }
+
+    if (!frame) {
+        if (finished) {
+            qDebug() << "倒放到达开头";
+            stopReverse(true);
+            emit reverseFinished();
+        }
+        // 还没预取到，等下一次
+        return;
+    }
+
+    int64_t pts = frame->pts;
+    av_frame_unref(videoFrameYUV);
+    av_frame_move_ref(videoFrameYUV, frame);
+    av_frame_free(&frame);
+    videoCurrentPts = pts;
+
+    filterDecodedFrame(true);
+    displayCurrentFrame();
+
+    AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+    reportPosition(pts * av_q2d(videoStream->time_base));
+}
+
+// reposition为true时把主解码器定位到倒放停下的位置，之后正常播放/逐帧从这里继续
+void VideoThread::stopReverse(bool reposition)
+{
+    if (!videoReverse.isActive()) {
+        return;
+    }
+
+    if (reverseTimer) {
+        reverseTimer->stop();
+    }
+    videoReverse.stop();
+
+    if (reposition && videoFormatCtx && videoCurrentPts != AV_NOPTS_VALUE) {
+        AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
+        int targetMs = static_cast<int>(videoCurrentPts * av_q2d(videoStream->time_base) * 1000);
+        decodeUntilTarget(targetMs, true);
+    }
+    qDebug() << "倒放停止";
+}
+
 void VideoThread::decodeUntilTarget(int targetMs, bool isBackwardSeek)
 {
     // 1. 暂停播放（如果正在播放）
@@ -862,16 +1352,27 @@ void VideoThread::decodeUntilTarget(int targetMs, bool isBackwardSeek)
                 videoStream->time_base
                 );
 
-    int ret = av_seek_frame(videoFormatCtx, videoStreamIndex,
-                            targetTimestamp, AVSEEK_FLAG_BACKWARD);
+    // 目标还在回看缓冲里时从缓冲里的关键帧重新解码，不用跳转读盘
+    if (videoPacketRing.rewindTo(targetTimestamp)) {
+        qDebug() << "回看缓冲命中：" << targetMs << "ms";
+    } else {
+        int ret = av_seek_frame(videoFormatCtx, videoStreamIndex,
+                                targetTimestamp, AVSEEK_FLAG_BACKWARD);
 
-    if (ret < 0) {
-        qDebug() << "跳转失败";
-        return;
+        if (ret < 0) {
+            qDebug() << "跳转失败";
+            return;
+        }
+        videoPacketRing.clear();
     }
 
-    // 3. 清空解码器
+    // 3. 清空解码器（滤镜里的历史帧、逐帧缓存也一起丢弃）
     avcodec_flush_buffers(videoCodecCtx);
+    videoFilter.release();
+    videoGopCache.clear();
+    videoDecodePts = AV_NOPTS_VALUE;
+    videoFastClock = targetSeconds;
+    videoFastPending = false;
 
     // 4. 显示第一帧（关键帧）给用户即时反馈
     seekAndDecodePrecisely(targetMs);
@@ -890,32 +1391,30 @@ void VideoThread::seekAndDecodePrecisely(int targetMs)
     const int MAX_NULL_PACKETS = 50;
 
     while (!foundTarget && consecutiveNullPackets < MAX_NULL_PACKETS) {
-        AVPacket packet;
-        av_init_packet(&packet);
-
-        int ret = av_read_frame(videoFormatCtx, &packet);
+        // 复用成员包（不再在栈上建包）
+        int ret = readVideoPacket(videoPacket);
         if (ret < 0) {
             consecutiveNullPackets++;
             continue;
         }
 
-        if (packet.stream_index != videoStreamIndex) {
-            av_packet_unref(&packet);
+        if (videoPacket->stream_index != videoStreamIndex) {
+            av_packet_unref(videoPacket);
             continue;
         }
 
         // 检查包时间
-        double packetTime = packet.pts * av_q2d(videoStream->time_base);
+        double packetTime = videoPacket->pts * av_q2d(videoStream->time_base);
         if (packetTime < targetSeconds - 5.0) {
             // 太早的包直接跳过不解码
             qDebug() << "跳过早期包：" << packetTime << "秒";
-            av_packet_unref(&packet);
+            av_packet_unref(videoPacket);
             continue;
         }
 
         // 发送到解码器
-        ret = avcodec_send_packet(videoCodecCtx, &packet);
-        av_packet_unref(&packet);
+        ret = avcodec_send_packet(videoCodecCtx, videoPacket);
+        av_packet_unref(videoPacket);
 
         if (ret < 0) {
             qDebug() << "发送包失败";
@@ -934,15 +1433,19 @@ void VideoThread::seekAndDecodePrecisely(int targetMs)
             }
 
             double frameTime = videoFrameYUV->pts * av_q2d(videoStream->time_base);
+            rememberDecodedFrame();
 
             if (frameTime >= targetSeconds || qAbs(frameTime - targetSeconds) < 0.1) {
                 // 找到目标帧
+                videoCurrentPts = videoDecodePts;
+                filterDecodedFrame(true);
                 displayCurrentFrame();
                 foundTarget = true;
                 qDebug() << "成功跳转到：" << frameTime << "秒";
 
                 // 继续清空解码器缓冲区
                 while (avcodec_receive_frame(videoCodecCtx, videoFrameYUV) >= 0) {
+                    rememberDecodedFrame();
                     av_frame_unref(videoFrameYUV);
                 }
                 break;
@@ -963,54 +1466,95 @@ void VideoThread::seekAndDecodePrecisely(int targetMs)
 
 void VideoThread::displayCurrentFrame()
 {
-    if (!videoFrameYUV || !videoCodecCtx || !sdlRenderer) {
+    if (!videoFrameYUV || !videoCodecCtx || !videoRenderer) {
         qDebug() << "显示失败：资源未初始化";
         return;
     }
 
-    // 1. YUV转RGB
-    if (videoSwsCtx) {
-        sws_scale(videoSwsCtx,
-                  videoFrameYUV->data, videoFrameYUV->linesize,
-                  0, videoCodecCtx->height,
-                  videoFrameRGB->data, videoFrameRGB->linesize);
-    } else {
-        qDebug() << "显示失败：videoSwsCtx为空";
+    // 1. YUV转RGB（按帧的实际尺寸/格式/色彩空间挑选转换器，中途变化时切换）
+    if (!ensureSwsContext(videoFrameYUV)) {
         return;
     }
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    qint64 toneBefore = videoConversion->tone.timing().totalNs;
+    videoConversion->convert(videoFrameYUV);
+    qint64 convertNs = stageTimer.nsecsElapsed();
+    PlaybackStats::convertNs.fetchAndAddRelaxed(convertNs);
+    PlaybackStats::toneNs.fetchAndAddRelaxed(videoConversion->tone.timing().totalNs - toneBefore);
+
+    // 2. 交给输出后端显示（SDL/QPainter/离屏）
+    videoRenderer->present(videoConversion->data[0], videoConversion->linesize[0],
+                           videoConversion->key.dstWidth, videoConversion->key.dstHeight,
+                           videoDisplayAspect);
+    PlaybackStats::presentNs.fetchAndAddRelaxed(stageTimer.nsecsElapsed() - convertNs);
+    PlaybackStats::presentedFrames.fetchAndAddRelaxed(1);
+}
 
-    // 2. 创建或更新SDL纹理
-    if (!sdlTexture) {
-        sdlTexture = SDL_CreateTexture(sdlRenderer,
-                                       SDL_PIXELFORMAT_RGB24,
-                                       SDL_TEXTUREACCESS_STREAMING,
-                                       videoCodecCtx->width,
-                                       videoCodecCtx->height);
-        if (!sdlTexture) {
-            qDebug() << "创建纹理失败：" << SDL_GetError();
-            return;
-        }
-        qDebug() << "创建新纹理";
+bool VideoThread::ensureSwsContext(const AVFrame* frame)
+{
+    int dstWidth = 0;
+    int dstHeight = 0;
+    scaledSize(frame, &dstWidth, &dstHeight);
+
+    videoConversion = videoConversions.acquire(frame, dstWidth, dstHeight, AV_PIX_FMT_RGB24);
+    if (!videoConversion) {
+        qDebug() << "显示失败：转换器为空";
+        return false;
+    }
+    return true;
+}
+
+void VideoThread::scaledSize(const AVFrame* frame, int* width, int* height)
+{
+    // 显示宽高比 = 像素宽高比(SAR) × 存储宽高比
+    AVRational sar = frame->sample_aspect_ratio;
+    if (sar.num <= 0 || sar.den <= 0) {
+        sar = av_guess_sample_aspect_ratio(videoFormatCtx, videoFormatCtx->streams[videoStreamIndex], nullptr);
     }
+    double sarValue = (sar.num > 0 && sar.den > 0) ? av_q2d(sar) : 1.0;
+    videoDisplayAspect = frame->width * sarValue / frame->height;
 
-    // 3. 更新纹理数据
-    int ret = SDL_UpdateTexture(sdlTexture,
-                                NULL,
-                                videoFrameRGB->data[0],
-            videoFrameRGB->linesize[0]);
-    if (ret != 0) {
-        qDebug() << "更新纹理失败：" << SDL_GetError();
+    *width = frame->width;
+    *height = frame->height;
+    if (videoDisplayWidth <= 0 || videoDisplayHeight <= 0) {
         return;
     }
 
-    // 4. 渲染
-    SDL_RenderClear(sdlRenderer);
-    SDL_RenderCopy(sdlRenderer, sdlTexture, NULL, NULL);
-    SDL_RenderPresent(sdlRenderer);
+    // 放进显示区域后的尺寸
+    double fitWidth = videoDisplayWidth;
+    double fitHeight = fitWidth / videoDisplayAspect;
+    if (fitHeight > videoDisplayHeight) {
+        fitHeight = videoDisplayHeight;
+        fitWidth = fitHeight * videoDisplayAspect;
+    }
+
+    // 只缩小不放大：显示区域比源大时按源尺寸转换，由输出后端放大
+    if (fitWidth * fitHeight >= (double)frame->width * frame->height) {
+        return;
+    }
+    *width = qMax(2, static_cast<int>(fitWidth) & ~1);
+    *height = qMax(2, static_cast<int>(fitHeight) & ~1);
+}
 
-    // 5. 强制处理SDL事件（确保显示）
-    SDL_PumpEvents();
+int VideoThread::chooseLowres(const AVCodec* codec)
+{
+    if (PlayerConfig::lowres == 0 || codec->max_lowres <= 0) {
+        return 0;
+    }
+    if (PlayerConfig::lowres > 0) {
+        return qMin(PlayerConfig::lowres, (int)codec->max_lowres);
+    }
 
+    // 自动：缩小后仍不小于显示区域的最大级别
+    AVCodecParameters* codecPar = videoFormatCtx->streams[videoStreamIndex]->codecpar;
+    int level = 0;
+    while (level < codec->max_lowres && videoDisplayWidth > 0 && videoDisplayHeight > 0 &&
+           (codecPar->width >> (level + 1)) >= videoDisplayWidth &&
+           (codecPar->height >> (level + 1)) >= videoDisplayHeight) {
+        level++;
+    }
+    return level;
 }
 
 double VideoThread::synchronizeVideo(double pts)
@@ -1024,7 +1568,6 @@ double VideoThread::synchronizeVideo(double pts)
     double diff = pts - audioTime;
 
     // 🔥 动态计算基础延迟（考虑当前速度）
-    static double m_baseDelayForSpeed = 0;
     if (m_baseDelayForSpeed <= 0 && videoFormatCtx && videoStreamIndex >= 0) {
         AVStream* videoStream = videoFormatCtx->streams[videoStreamIndex];
         double fps = av_q2d(videoStream->avg_frame_rate);
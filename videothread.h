@@ -10,8 +10,16 @@
 #include <QWidget>
 #include <QWindow>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include "global_status.h"
 #include "audiothread.h"
+#include "videofilter.h"
+#include "gopcache.h"
+#include "packetring.h"
+#include "reversedecoder.h"
+#include "conversioncache.h"
+#include "renderbackend.h"
+#include "playerconfig.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -33,13 +41,17 @@ public:
 
 signals:
     void UpadatButton(bool flag);
-    void UpadatStatus(QString value,double time);
     void UpadatseekSlider(double);
+    void reverseFinished();//倒放到了开头
+    void fastForwardFinished(qint64 positionMs);//快进结束，音频跳到这个位置
 public slots:
     void init_video(QString path);
-    void UpadatStatus();
     void setPlaybackSpeed(float speed);//倍速设置
     void setSeekSlider(int flog,int value);
+    void setVideoFilters(QString filters);//设置视频滤镜链（空字符串关闭）
+    void setDisplaySize(int width, int height);//显示区域大小（物理像素）变化
+    void stepFrame(int direction);//逐帧（1下一帧，-1上一帧），保持暂停
+    void setReversePlayback(float speed);//倒放（speed<=0停止倒放）
 
 
 
@@ -49,7 +61,7 @@ public:
     int findVideoStream(AVFormatContext* formatCtx);
 
     bool initVideoDecoder();
-    bool initSDLDisplay();
+    bool initRenderBackend();
 
 
     void startPlayback();//开始视频播放
@@ -57,13 +69,13 @@ public:
     void onPlayTimerTimeout();//显示一帧图像
     QString formatTime(qint64 seconds);//时间格式转换
     void pausePlayback();//// 暂停播放（从PLAYING到PAUSED）
-    void restartPlayback();// 重新播放（从ENDED到PLAYING）
+    bool prerollVideo();// 回到开头解出第一帧并显示，进入READY（定时器等音频填好后再开）
     void resumePlayback();// 继续播放（从PAUSED到PLAYING）
     void onPlayFinished();// 播放结束（从PLAYING到ENDED）
     void resetToBeginning();//确定视频从头开始播放
 
     void cleanup();
-    void cleanupSDL();
+    void cleanupRender();
 
 
     void setDisplayWidget(QWidget *widget);
@@ -71,6 +83,27 @@ public:
     //跳转
     void toSeek(int value);
     void displayCurrentFrame();
+    bool presentDecodedFrame();//按音频时钟同步并显示当前解码帧
+    bool filterDecodedFrame(bool fallbackToSource = false);//解码帧经过滤镜
+    bool ensureSwsContext(const AVFrame* frame);//按帧参数和显示区域取出（或新建）转换器
+    void scaledSize(const AVFrame* frame, int* width, int* height);//按显示区域和SAR算出转换目标尺寸
+    int chooseLowres(const AVCodec* codec);
+    void reportPosition(double currentTime);//记下当前时间（界面轮询）
+    void rememberDecodedFrame();//解码帧放进逐帧缓存
+    int readVideoPacket(AVPacket* packet);//取下一个视频包（回看缓冲回放中先从缓冲里取），返回值同av_read_frame
+    bool decodeForStep(int64_t seekPts, int64_t stopPts);//逐帧缓存未命中时解码补齐
+    void showStepFrame(const AVFrame* frame, int64_t pts);
+    void onReverseTimerTimeout();//倒放显示一帧
+    void finishPlayback();//读到文件末尾
+    void setLoop(qint64 startMs, qint64 endMs);//循环区间（startMs<0关闭，endMs<0到文件末尾）
+    void wrapLoop();//到循环终点，回到起点接着播
+    void captureLoopHead(const AVPacket* packet);//记下循环起点附近的包
+    void clearLoopHead();
+    int64_t loopStartPts() const;//循环起点（流时间基）
+    void enterFastForward(float speed);//4x/8x/16x快进
+    void leaveFastForward();
+    void fastForwardTick();//快进时显示一帧
+    void stopReverse(bool reposition);
     void decodeUntilTarget(int targetMs, bool isBackwardSeek);
     void seekAndDecodePrecisely(int targetMs);
 
@@ -78,6 +111,11 @@ public:
 
     void setAudioReference(AudioThread* audio);  // "认识"音频线程
 
+    int64_t currentPts() const;//当前显示帧的pts（流时间基），回归测试用
+    double currentPosition() const;//当前显示帧的时间（秒），没有时为-1
+    qint64 decodedFrames() const;//累计解码帧数（不含快进）
+    RenderBackend* renderer() const;//当前输出后端
+
 private:
 
     int total_time = 0;
@@ -90,16 +128,48 @@ private:
     AVFormatContext* videoFormatCtx = nullptr;  // 视频文件上下文
     AVCodecContext* videoCodecCtx = nullptr;    // 视频解码器
     AVFrame* videoFrameYUV = nullptr;           // YUV帧（解码后）
-    AVFrame* videoFrameRGB = nullptr;           // RGB帧（转换后）
-    SwsContext* videoSwsCtx = nullptr;          // 视频格式转换器
+    ConversionCache videoConversions;           // 按帧参数缓存的转换器和RGB缓冲（中途换分辨率/格式）
+    Conversion* videoConversion = nullptr;      // 当前帧使用的转换器
     AVPacket* videoPacket = nullptr;            // 视频数据包
     int videoStreamIndex = -1;                  // 视频流索引
-
-
-    // SDL相关
-    SDL_Window* sdlWindow = nullptr;
-    SDL_Renderer* sdlRenderer = nullptr;
-    SDL_Texture* sdlTexture = nullptr;
+    double videoDisplayAspect = 0;              // 画面显示宽高比（已计入SAR）
+    int videoDisplayWidth = 0;                  // 显示区域宽度（物理像素）
+    int videoDisplayHeight = 0;                 // 显示区域高度
+
+    // 视频滤镜
+    VideoFilterGraph videoFilter;               // 解码后的滤镜阶段
+    QString videoFilterDesc;                    // 当前滤镜链描述
+    AVFrame* videoFrameBackup = nullptr;        // 滤镜无输出时保留的原始帧（跳转预览用）
+    int videoFilteredFrames = 0;                // 已过滤帧数（定期输出耗时）
+
+    // 逐帧
+    GopCache videoGopCache;                     // 当前GOP附近的已解码帧
+    PacketRing videoPacketRing;                 // 最近几秒的视频包（短距离后退不读盘）
+    int64_t videoCurrentPts = AV_NOPTS_VALUE;   // 当前显示帧的pts（流时间基）
+    int64_t videoDecodePts = AV_NOPTS_VALUE;    // 解码器最近输出帧的pts
+    qint64 videoDecodedFrames = 0;              // 累计解码帧数（基准测试统计每次跳转的解码量）
+
+    // 循环播放
+    qint64 videoLoopStartMs = -1;               // 循环起点，-1表示不循环
+    qint64 videoLoopEndMs = -1;                 // 循环终点，-1表示文件末尾
+    QList<AVPacket*> videoLoopHead;             // 起点前的关键帧开始的一段包（回看缓冲装不下整段循环时用）
+    PacketPool videoLoopHeadPool;               // 这段包的结构体（重新存时复用）
+    int64_t videoLoopHeadEnd = AV_NOPTS_VALUE;  // 这段包之后第一个关键帧的pts，存好之前为AV_NOPTS_VALUE
+
+    // 倒放
+    ReverseDecoder videoReverse;                // 后台分段解码
+    QTimer *reverseTimer = nullptr;             // 倒放显示定时器
+    int videoReverseFramesPerTick = 1;          // 高倍速时每次跳过的帧数
+
+    // 快进（2倍以上）
+    float videoFastSpeed = 0;                   // 0表示正常播放
+    double videoFastClock = 0;                  // 快进时视频自己的时钟（秒）
+    QElapsedTimer videoFastWall;                // 推进快进时钟
+    bool videoFastPending = false;              // videoFrameYUV里有一帧还没到显示时间
+
+
+    // 输出
+    RenderBackend* videoRenderer = nullptr;     // 视频输出后端（--render选择）
     QWidget *m_displayWidget = nullptr;
     WId widgetId;
 
@@ -111,12 +181,15 @@ private:
     //拖动
     QString VideoFile = nullptr;
 
-    AudioThread* m_audioRef;  // 保存音频的引用
+    AudioThread* m_audioRef = nullptr;  // 保存音频的引用（没有音频时按视频自己的节奏播放）
     double getAudioTime();     // 获取音频时间
 
 
     // 同步相关
     double m_frameLastDelay;     // 上一帧的实际延迟
+    int m_syncLastInterval = 0;         // 上次设置的定时器间隔（毫秒）
+    double m_baseDelayForSpeed = 0;     // 1倍速时的帧间隔（秒），按文件帧率算一次
+    void resetSync();                   // 打开新文件时清零上面几项
 
     // 同步方法
     double synchronizeVideo(double pts);
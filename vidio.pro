@@ -15,16 +15,42 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# 源码目录，黄金帧期望文件golden_frames.txt和源码放在一起
+DEFINES += VIDIO_SOURCE_DIR=\\\"$$PWD\\\"
+
 
 
 SOURCES += \
+    audiofilter.cpp \
     audiothread.cpp \
-    global_status.cpp \
+    benchmark.cpp \
+    conversioncache.cpp \
+    gopcache.cpp \
+    loudnessscanner.cpp \
     main.cpp \
     mainwindow.cpp \
+    mediapool.cpp \
+    memorybudget.cpp \
+    offscreenrenderbackend.cpp \
+    packetring.cpp \
+    playbackstats.cpp \
+    playerconfig.cpp \
+    playerengine.cpp \
+    qtrenderbackend.cpp \
+    renderbackend.cpp \
+    reversedecoder.cpp \
+    scenedetector.cpp \
+    sdlrenderbackend.cpp \
     seekslider.cpp \
+    slicescaler.cpp \
+    syncmeter.cpp \
+    testclip.cpp \
+    tonemapper.cpp \
+    videofilter.cpp \
     videolistitem.cpp \
-    videothread.cpp
+    videothread.cpp \
+    waveformbuilder.cpp \
+    yuvconverter.cpp
 
 win32 {
 INCLUDEPATH += $$PWD/include
@@ -45,12 +71,36 @@ LIBS += $$PWD/lib/avformat.lib   \
 
 
 HEADERS += \
+    audiofilter.h \
     audiothread.h \
+    benchmark.h \
+    conversioncache.h \
     global_status.h \
+    gopcache.h \
+    loudnessscanner.h \
     mainwindow.h \
+    mediapool.h \
+    memorybudget.h \
+    offscreenrenderbackend.h \
+    packetring.h \
+    playbackstats.h \
+    playerconfig.h \
+    playerengine.h \
+    qtrenderbackend.h \
+    renderbackend.h \
+    reversedecoder.h \
+    scenedetector.h \
+    sdlrenderbackend.h \
     seekslider.h \
+    slicescaler.h \
+    syncmeter.h \
+    testclip.h \
+    tonemapper.h \
+    videofilter.h \
     videolistitem.h \
-    videothread.h
+    videothread.h \
+    waveformbuilder.h \
+    yuvconverter.h
 
 FORMS += \
     mainwindow.ui
@@ -63,3 +113,6 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 RESOURCES += \
     resource.qrc
+
+DISTFILES += \
+    golden_frames.txt
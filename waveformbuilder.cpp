@@ -0,0 +1,344 @@
+#include "waveformbuilder.h"
+#include "loudnessscanner.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtConcurrent>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+#include <libavutil/channel_layout.h>
+}
+
+// 波形桶数（与控件宽度同一量级即可，多小时的录音也够用）
+static const int WAVEFORM_BUCKETS = 2048;
+// 峰值文件头
+static const char PEAK_FILE_MAGIC[4] = { 'B', 'P', 'K', '1' };
+
+WaveformBuilder::WaveformBuilder(QObject *parent) : QObject(parent)
+{
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+WaveformBuilder::~WaveformBuilder()
+{
+    // 不能clear()：被删掉的段的future永远不会完成，调度任务会一直等
+    m_cancelled.storeRelease(1);
+    for (QFuture<void> &driver : m_drivers) {
+        driver.waitForFinished();
+    }
+    m_pool.waitForDone();
+}
+
+WaveformData WaveformBuilder::waveform(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_results.value(filePath);
+}
+
+void WaveformBuilder::build(const QString &filePath)
+{
+    bool cached = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        cached = m_results.contains(filePath);
+        if (!cached) {
+            if (m_building == filePath) {
+                return;
+            }
+            m_building = filePath;
+        }
+    }
+    // 信号在锁外发，槽里会再调waveform()
+    if (cached) {
+        emit waveformReady(filePath);
+        return;
+    }
+
+    // 已经结束的调度任务不用再记着
+    for (int i = m_drivers.size() - 1; i >= 0; i--) {
+        if (m_drivers.at(i).isFinished()) {
+            m_drivers.removeAt(i);
+        }
+    }
+
+    QThreadPool *pool = &m_pool;
+    m_drivers.append(QtConcurrent::run([this, pool, filePath]() {
+        WaveformData data;
+        QString peakFile = peakFilePath(filePath);
+
+        // 先读峰值文件，没有再解码
+        if (!loadPeakFile(peakFile, &data)) {
+            if (!computeWaveform(pool, &m_cancelled, filePath, &data) || m_cancelled.loadAcquire()) {
+                QMutexLocker locker(&m_mutex);
+                // 期间可能已经开始生成别的文件，那个标记不是这里的
+                if (m_building == filePath) {
+                    m_building.clear();
+                }
+                return;
+            }
+            savePeakFile(peakFile, data);
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_results.insert(filePath, data);
+            if (m_building == filePath) {
+                m_building.clear();
+            }
+        }
+        emit waveformReady(filePath);
+    }));
+}
+
+bool WaveformBuilder::computeWaveform(QThreadPool *pool, const QAtomicInt *cancelled,
+                                      const QString &filePath, WaveformData *data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 只为了拿时长
+    AVFormatContext *formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, filePath.toUtf8().constData(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    double duration = 0;
+    if (avformat_find_stream_info(formatCtx, nullptr) >= 0 && formatCtx->duration > 0) {
+        duration = formatCtx->duration / (double)AV_TIME_BASE;
+    }
+    bool hasAudio = av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0) >= 0;
+    avformat_close_input(&formatCtx);
+
+    if (duration <= 0 || !hasAudio) {
+        return false;
+    }
+
+    data->mins.fill(0, WAVEFORM_BUCKETS);
+    data->maxs.fill(0, WAVEFORM_BUCKETS);
+    double bucketSeconds = duration / WAVEFORM_BUCKETS;
+
+    // 每个线程负责一段连续的桶，桶不重叠所以可以直接写同一个数组
+    int segments = qMax(1, pool->maxThreadCount() * 2);
+    QVector<QFuture<bool>> futures;
+    for (int i = 0; i < segments; i++) {
+        int first = WAVEFORM_BUCKETS * i / segments;
+        int last = WAVEFORM_BUCKETS * (i + 1) / segments;
+        futures.append(QtConcurrent::run(pool, [=]() {
+            // 取消后还没开始的段不再解码
+            if (cancelled->loadAcquire()) {
+                return false;
+            }
+            return decodeSegment(filePath, first, last, bucketSeconds, data);
+        }));
+    }
+
+    bool ok = true;
+    for (QFuture<bool> &future : futures) {
+        future.waitForFinished();
+        ok = future.result() && ok;
+    }
+
+    qDebug() << "波形生成完成:" << QFileInfo(filePath).fileName() << segments << "段，用时"
+             << timer.elapsed() << "ms";
+    return ok;
+}
+
+bool WaveformBuilder::decodeSegment(const QString &filePath, int firstBucket, int lastBucket,
+                                    double bucketSeconds, WaveformData *data)
+{
+    AVFormatContext *formatCtx = nullptr;
+    AVCodecContext *codecCtx = nullptr;
+    SwrContext *swrCtx = nullptr;
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    float *samples = nullptr;
+    int samplesCapacity = 0;
+    bool ok = false;
+
+    double startSeconds = firstBucket * bucketSeconds;
+    double endSeconds = lastBucket * bucketSeconds;
+
+    do {
+        if (avformat_open_input(&formatCtx, filePath.toUtf8().constData(), nullptr, nullptr) < 0) {
+            break;
+        }
+        if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+            break;
+        }
+        int streamIndex = av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+        if (streamIndex < 0) {
+            break;
+        }
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+            if ((int)i != streamIndex) {
+                formatCtx->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
+        AVStream *stream = formatCtx->streams[streamIndex];
+        // 桶的时间从流的起始时间算起
+        double streamStart = (stream->start_time != AV_NOPTS_VALUE)
+                ? stream->start_time * av_q2d(stream->time_base) : 0.0;
+        const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (!codec) {
+            break;
+        }
+        codecCtx = avcodec_alloc_context3(codec);
+        if (!codecCtx || avcodec_parameters_to_context(codecCtx, stream->codecpar) < 0 ||
+                avcodec_open2(codecCtx, codec, nullptr) < 0) {
+            break;
+        }
+
+        // 下混成单声道浮点，方便取最大最小值
+        int64_t layout = codecCtx->channel_layout;
+        if (layout == 0) {
+            layout = av_get_default_channel_layout(codecCtx->channels);
+        }
+        swrCtx = swr_alloc_set_opts(nullptr,
+                                    AV_CH_LAYOUT_MONO, AV_SAMPLE_FMT_FLT, codecCtx->sample_rate,
+                                    layout, codecCtx->sample_fmt, codecCtx->sample_rate,
+                                    0, nullptr);
+        if (!swrCtx || swr_init(swrCtx) < 0) {
+            break;
+        }
+
+        if (firstBucket > 0) {
+            int64_t target = (int64_t)((startSeconds + streamStart) * AV_TIME_BASE);
+            av_seek_frame(formatCtx, -1, target, AVSEEK_FLAG_BACKWARD);
+        }
+
+        packet = av_packet_alloc();
+        frame = av_frame_alloc();
+        if (!packet || !frame) {
+            break;
+        }
+
+        bool done = false;
+        while (!done) {
+            int ret = av_read_frame(formatCtx, packet);
+            if (ret < 0) {
+                avcodec_send_packet(codecCtx, nullptr);
+                done = true;
+            } else if (packet->stream_index == streamIndex) {
+                avcodec_send_packet(codecCtx, packet);
+                av_packet_unref(packet);
+            } else {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            while (avcodec_receive_frame(codecCtx, frame) >= 0) {
+                double frameStart = (frame->pts != AV_NOPTS_VALUE)
+                        ? frame->pts * av_q2d(stream->time_base) - streamStart : startSeconds;
+                if (frameStart >= endSeconds) {
+                    done = true;
+                    av_frame_unref(frame);
+                    break;
+                }
+
+                if (samplesCapacity < frame->nb_samples + 256) {
+                    av_freep(&samples);
+                    samplesCapacity = frame->nb_samples + 256;
+                    samples = (float*)av_malloc(samplesCapacity * sizeof(float));
+                }
+                uint8_t *out = (uint8_t*)samples;
+                int count = swr_convert(swrCtx, &out, samplesCapacity,
+                                        (const uint8_t**)frame->data, frame->nb_samples);
+
+                // 只统计落在本段内的采样，段边界不会重复计算
+                for (int i = 0; i < count; i++) {
+                    double t = frameStart + i / (double)codecCtx->sample_rate;
+                    int bucket = static_cast<int>(t / bucketSeconds);
+                    if (bucket < firstBucket || bucket >= lastBucket) {
+                        continue;
+                    }
+                    int value = qBound(-127, static_cast<int>(samples[i] * 127.0f), 127);
+                    if (value < data->mins[bucket]) {
+                        data->mins[bucket] = static_cast<qint8>(value);
+                    }
+                    if (value > data->maxs[bucket]) {
+                        data->maxs[bucket] = static_cast<qint8>(value);
+                    }
+                }
+                av_frame_unref(frame);
+            }
+        }
+        ok = true;
+    } while (false);
+
+    av_freep(&samples);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    swr_free(&swrCtx);
+    avcodec_free_context(&codecCtx);
+    avformat_close_input(&formatCtx);
+    return ok;
+}
+
+QString WaveformBuilder::peakFilePath(const QString &filePath)
+{
+    QString dir = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+            .filePath("waveforms");
+    QDir().mkpath(dir);
+
+    QByteArray hash = QCryptographicHash::hash(LoudnessCache::fileKey(filePath).toUtf8(),
+                                               QCryptographicHash::Md5).toHex();
+    return QDir(dir).filePath(QString::fromLatin1(hash.constData()) + ".peaks");
+}
+
+// 峰值文件格式：4字节标识 + 4字节桶数 + 桶数个(min,max)
+bool WaveformBuilder::loadPeakFile(const QString &path, WaveformData *data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    char magic[4];
+    qint32 count = 0;
+    if (file.read(magic, 4) != 4 || memcmp(magic, PEAK_FILE_MAGIC, 4) != 0 ||
+            file.read((char*)&count, sizeof(count)) != sizeof(count) ||
+            count <= 0 || count > 1 << 20) {
+        return false;
+    }
+
+    QVector<qint8> pairs(count * 2);
+    if (file.read((char*)pairs.data(), pairs.size()) != pairs.size()) {
+        return false;
+    }
+
+    data->mins.resize(count);
+    data->maxs.resize(count);
+    for (int i = 0; i < count; i++) {
+        data->mins[i] = pairs[i * 2];
+        data->maxs[i] = pairs[i * 2 + 1];
+    }
+    return true;
+}
+
+bool WaveformBuilder::savePeakFile(const QString &path, const WaveformData &data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入峰值文件:" << path;
+        return false;
+    }
+
+    qint32 count = data.size();
+    QVector<qint8> pairs(count * 2);
+    for (int i = 0; i < count; i++) {
+        pairs[i * 2] = data.mins[i];
+        pairs[i * 2 + 1] = data.maxs[i];
+    }
+
+    file.write(PEAK_FILE_MAGIC, 4);
+    file.write((const char*)&count, sizeof(count));
+    file.write((const char*)pairs.constData(), pairs.size());
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef WAVEFORMBUILDER_H
+#define WAVEFORMBUILDER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QThreadPool>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QList>
+
+// 波形概览：每个桶保存这一段时间内的最小/最大采样（-127~127）
+struct WaveformData {
+    QVector<qint8> mins;
+    QVector<qint8> maxs;
+
+    bool isEmpty() const { return mins.isEmpty(); }
+    int size() const { return mins.size(); }
+};
+
+// 后台生成音频波形：按时间把音轨切成若干段并行解码，每个工作线程独立打开文件
+// 结果写成降采样的峰值文件，下次打开同一文件直接读取
+class WaveformBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformBuilder(QObject *parent = nullptr);
+    ~WaveformBuilder();
+
+    void build(const QString &filePath);
+    WaveformData waveform(const QString &filePath);
+
+signals:
+    void waveformReady(QString filePath);
+
+private:
+    static bool computeWaveform(QThreadPool *pool, const QAtomicInt *cancelled,
+                                const QString &filePath, WaveformData *data);
+    static bool decodeSegment(const QString &filePath, int firstBucket, int lastBucket,
+                              double bucketSeconds, WaveformData *data);
+    static QString peakFilePath(const QString &filePath);
+    static bool loadPeakFile(const QString &path, WaveformData *data);
+    static bool savePeakFile(const QString &path, const WaveformData &data);
+
+    QThreadPool m_pool;                 // 分段解码用
+    QList<QFuture<void>> m_drivers;     // 每个文件一个调度任务（析构时等它们结束）
+    QAtomicInt m_cancelled;             // 析构时置位，还没开始的段直接跳过
+    QMutex m_mutex;
+    QHash<QString, WaveformData> m_results;
+    QString m_building;                 // 正在生成的文件
+};
+
+#endif // WAVEFORMBUILDER_H
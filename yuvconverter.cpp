@@ -0,0 +1,257 @@
+#include "yuvconverter.h"
+#include <QDebug>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define YUV_HAVE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang需要在函数上单独打开AVX2，MSVC直接可用
+#if defined(__GNUC__) || defined(__clang__)
+#define YUV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define YUV_TARGET_AVX2
+#endif
+
+// 定点运算约定：输入先左移7位，与Q13系数做带舍入的高位乘法（即_mm256_mulhrs_epi16），
+// 得到Q5的分量，最后(+16)>>5并饱和到0~255。标量实现逐步照抄，保证两边结果一致
+static inline int mulhrs(int a, int b)
+{
+    return (a * b + 0x4000) >> 15;
+}
+
+static inline uint8_t clampPixel(int value)
+{
+    value = (value + 16) >> 5;
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// 转换一行中[from, to)的像素；chromaStep为色度样本间距（平面1，NV12为2）
+static void convertRowScalar(const YuvConverter::Coefficients &c,
+                             const uint8_t *y, const uint8_t *u, const uint8_t *v, int chromaStep,
+                             uint8_t *dst, int pixelBytes, bool bgr, int from, int to)
+{
+    int first = bgr ? 2 : 0;
+    int last = bgr ? 0 : 2;
+    for (int x = from; x < to; x++) {
+        int ci = (x >> 1) * chromaStep;
+        int yq = mulhrs((y[x] - c.yOffset) << 7, c.yScale);
+        int uq = (u[ci] - 128) << 7;
+        int vq = (v[ci] - 128) << 7;
+
+        uint8_t *p = dst + x * pixelBytes;
+        p[first] = clampPixel(yq + mulhrs(vq, c.rv));
+        p[1] = clampPixel(yq - mulhrs(uq, c.gu) - mulhrs(vq, c.gv));
+        p[last] = clampPixel(yq + mulhrs(uq, c.bu));
+        if (pixelBytes == 4) {
+            p[3] = 255;
+        }
+    }
+}
+
+#ifdef YUV_HAVE_X86
+// 每次16个像素，返回处理到的位置，剩下的交给标量
+YUV_TARGET_AVX2
+static int convertRowAvx2(const YuvConverter::Coefficients &c,
+                          const uint8_t *y, const uint8_t *u, const uint8_t *v, bool interleaved,
+                          uint8_t *dst, int pixelBytes, bool bgr, int width)
+{
+    const __m256i yOffset = _mm256_set1_epi16(c.yOffset);
+    const __m256i yScale = _mm256_set1_epi16(c.yScale);
+    const __m256i rv = _mm256_set1_epi16(c.rv);
+    const __m256i gu = _mm256_set1_epi16(c.gu);
+    const __m256i gv = _mm256_set1_epi16(c.gv);
+    const __m256i bu = _mm256_set1_epi16(c.bu);
+    const __m256i chromaBias = _mm256_set1_epi16(128);
+    const __m256i round = _mm256_set1_epi16(16);
+    const __m256i alpha = _mm256_set1_epi16(255);
+    // NV12的UV交错，拆开并每个色度样本复制两次
+    const __m128i splitU = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6, 8, 8, 10, 10, 12, 12, 14, 14);
+    const __m128i splitV = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7, 9, 9, 11, 11, 13, 13, 15, 15);
+    // 每128位4个像素去掉alpha，16字节压成12字节
+    const __m256i packRgb = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                             0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+    // RGB24按16字节重叠写，最后一次多写4字节，要求后面还有2个像素
+    int limit = (pixelBytes == 3) ? width - 18 : width - 16;
+    int x = 0;
+    for (; x <= limit; x += 16) {
+        __m128i y8 = _mm_loadu_si128((const __m128i *)(y + x));
+        __m128i u8;
+        __m128i v8;
+        if (interleaved) {
+            __m128i uv = _mm_loadu_si128((const __m128i *)(u + x));
+            u8 = _mm_shuffle_epi8(uv, splitU);
+            v8 = _mm_shuffle_epi8(uv, splitV);
+        } else {
+            u8 = _mm_loadl_epi64((const __m128i *)(u + x / 2));
+            v8 = _mm_loadl_epi64((const __m128i *)(v + x / 2));
+            u8 = _mm_unpacklo_epi8(u8, u8);
+            v8 = _mm_unpacklo_epi8(v8, v8);
+        }
+
+        __m256i yq = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(y8), yOffset), 7);
+        __m256i uq = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(u8), chromaBias), 7);
+        __m256i vq = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(v8), chromaBias), 7);
+        yq = _mm256_mulhrs_epi16(yq, yScale);
+
+        __m256i r = _mm256_add_epi16(yq, _mm256_mulhrs_epi16(vq, rv));
+        __m256i g = _mm256_sub_epi16(_mm256_sub_epi16(yq, _mm256_mulhrs_epi16(uq, gu)),
+                                     _mm256_mulhrs_epi16(vq, gv));
+        __m256i b = _mm256_add_epi16(yq, _mm256_mulhrs_epi16(uq, bu));
+        r = _mm256_srai_epi16(_mm256_add_epi16(r, round), 5);
+        g = _mm256_srai_epi16(_mm256_add_epi16(g, round), 5);
+        b = _mm256_srai_epi16(_mm256_add_epi16(b, round), 5);
+
+        // packus按128位分别处理：每半边是[c0 0~7, c1 0~7]和[c0 8~15, c1 8~15]
+        __m256i c01 = _mm256_packus_epi16(bgr ? b : r, g);
+        __m256i c2a = _mm256_packus_epi16(bgr ? r : b, alpha);
+        __m256i p01 = _mm256_unpacklo_epi8(c01, _mm256_srli_si256(c01, 8));
+        __m256i p2a = _mm256_unpacklo_epi8(c2a, _mm256_srli_si256(c2a, 8));
+        __m256i lo = _mm256_unpacklo_epi16(p01, p2a);  // 像素0~3 | 8~11
+        __m256i hi = _mm256_unpackhi_epi16(p01, p2a);  // 像素4~7 | 12~15
+        __m256i out0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i out1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+        if (pixelBytes == 4) {
+            _mm256_storeu_si256((__m256i *)(dst + x * 4), out0);
+            _mm256_storeu_si256((__m256i *)(dst + x * 4 + 32), out1);
+        } else {
+            out0 = _mm256_shuffle_epi8(out0, packRgb);
+            out1 = _mm256_shuffle_epi8(out1, packRgb);
+            uint8_t *p = dst + x * 3;
+            _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(out0));
+            _mm_storeu_si128((__m128i *)(p + 12), _mm256_extracti128_si256(out0, 1));
+            _mm_storeu_si128((__m128i *)(p + 24), _mm256_castsi256_si128(out1));
+            _mm_storeu_si128((__m128i *)(p + 36), _mm256_extracti128_si256(out1, 1));
+        }
+    }
+    return x;
+}
+#endif
+
+bool YuvConverter::supports(AVPixelFormat srcFormat, AVPixelFormat dstFormat)
+{
+    bool srcOk = (srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVJ420P ||
+                  srcFormat == AV_PIX_FMT_NV12);
+    bool dstOk = (dstFormat == AV_PIX_FMT_RGB24 || dstFormat == AV_PIX_FMT_BGRA ||
+                  dstFormat == AV_PIX_FMT_RGBA);
+    return srcOk && dstOk;
+}
+
+bool YuvConverter::hasAvx2()
+{
+#if defined(YUV_HAVE_X86) && defined(_MSC_VER)
+    static const bool supported = []() {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        // 还要确认操作系统保存YMM寄存器（OSXSAVE + XCR0）
+        __cpuid(info, 1);
+        if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+#elif defined(YUV_HAVE_X86)
+    static const bool supported = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+const char *YuvConverter::kernelName(Kernel kernel)
+{
+    return kernel == KernelAvx2 ? "AVX2" : "标量";
+}
+
+AVColorSpace YuvConverter::guessColorspace(AVColorSpace colorspace, int height)
+{
+    if (colorspace == AVCOL_SPC_UNSPECIFIED || colorspace == AVCOL_SPC_RGB) {
+        return (height >= 720) ? AVCOL_SPC_BT709 : AVCOL_SPC_SMPTE170M;
+    }
+    return colorspace;
+}
+
+bool YuvConverter::init(int width, int height, AVPixelFormat srcFormat, AVPixelFormat dstFormat,
+                        AVColorSpace colorspace, AVColorRange range, Kernel kernel)
+{
+    m_valid = false;
+    if (!supports(srcFormat, dstFormat) || width <= 0 || height <= 0) {
+        return false;
+    }
+    if (kernel == KernelAvx2 && !hasAvx2()) {
+        kernel = KernelScalar;
+    }
+
+    colorspace = guessColorspace(colorspace, height);
+    double kr = 0.299;
+    double kb = 0.114;
+    if (colorspace == AVCOL_SPC_BT709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    } else if (colorspace == AVCOL_SPC_BT2020_NCL || colorspace == AVCOL_SPC_BT2020_CL) {
+        kr = 0.2627;
+        kb = 0.0593;
+    } else {
+        colorspace = AVCOL_SPC_SMPTE170M;
+    }
+    bool fullRange = (range == AVCOL_RANGE_JPEG || srcFormat == AV_PIX_FMT_YUVJ420P);
+
+    double kg = 1.0 - kr - kb;
+    double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+    double cScale = fullRange ? 1.0 : 255.0 / 224.0;
+    auto q13 = [](double value) { return (int16_t)std::lround(value * 8192.0); };
+    m_coef.yOffset = fullRange ? 0 : 16;
+    m_coef.yScale = q13(yScale);
+    m_coef.rv = q13(2.0 * (1.0 - kr) * cScale);
+    m_coef.gu = q13(2.0 * (1.0 - kb) * kb / kg * cScale);
+    m_coef.gv = q13(2.0 * (1.0 - kr) * kr / kg * cScale);
+    m_coef.bu = q13(2.0 * (1.0 - kb) * cScale);
+
+    m_width = width;
+    m_height = height;
+    m_nv12 = (srcFormat == AV_PIX_FMT_NV12);
+    m_colorspace = colorspace;
+    m_fullRange = fullRange;
+    m_pixelBytes = (dstFormat == AV_PIX_FMT_RGB24) ? 3 : 4;
+    m_bgr = (dstFormat == AV_PIX_FMT_BGRA);
+    m_kernel = kernel;
+    m_valid = true;
+    return true;
+}
+
+void YuvConverter::convert(const AVFrame *frame, uint8_t *dst, int dstLinesize) const
+{
+    if (!m_valid || frame->width != m_width || frame->height != m_height) {
+        return;
+    }
+
+    for (int row = 0; row < m_height; row++) {
+        int chromaRow = row >> 1;
+        const uint8_t *y = frame->data[0] + (ptrdiff_t)row * frame->linesize[0];
+        const uint8_t *u = frame->data[1] + (ptrdiff_t)chromaRow * frame->linesize[1];
+        const uint8_t *v = m_nv12 ? u + 1 : frame->data[2] + (ptrdiff_t)chromaRow * frame->linesize[2];
+        uint8_t *out = dst + (ptrdiff_t)row * dstLinesize;
+
+        int x = 0;
+#ifdef YUV_HAVE_X86
+        if (m_kernel == KernelAvx2) {
+            x = convertRowAvx2(m_coef, y, u, v, m_nv12, out, m_pixelBytes, m_bgr, m_width);
+        }
+#endif
+        convertRowScalar(m_coef, y, u, v, m_nv12 ? 2 : 1, out, m_pixelBytes, m_bgr, x, m_width);
+    }
+}
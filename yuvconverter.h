@@ -0,0 +1,68 @@
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include <QtGlobal>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// 手写的YUV420P/NV12 -> RGB24/BGRA/RGBA转换（不缩放），
+// 运行时按CPU选AVX2或标量实现；两者整数运算完全一致，输出逐字节相同
+class YuvConverter
+{
+public:
+    enum Kernel {
+        KernelScalar,
+        KernelAvx2,
+    };
+
+    // 定点系数（Q13），标量和AVX2共用
+    struct Coefficients {
+        int16_t yOffset;
+        int16_t yScale;
+        int16_t rv;
+        int16_t gu;
+        int16_t gv;
+        int16_t bu;
+    };
+
+    // 源/目标格式是否在支持范围内
+    static bool supports(AVPixelFormat srcFormat, AVPixelFormat dstFormat);
+    // CPU（和操作系统）是否支持AVX2
+    static bool hasAvx2();
+    static Kernel bestKernel() { return hasAvx2() ? KernelAvx2 : KernelScalar; }
+    static const char *kernelName(Kernel kernel);
+    // 未标注的色彩空间按分辨率猜：高清用BT.709，标清用BT.601
+    static AVColorSpace guessColorspace(AVColorSpace colorspace, int height);
+
+    // colorspace/range未指定时按高度和格式推断
+    bool init(int width, int height, AVPixelFormat srcFormat, AVPixelFormat dstFormat,
+              AVColorSpace colorspace, AVColorRange range, Kernel kernel);
+    void release() { m_valid = false; }
+
+    bool isValid() const { return m_valid; }
+    Kernel kernel() const { return m_kernel; }
+    // 实际使用的矩阵和范围
+    AVColorSpace colorspace() const { return m_colorspace; }
+    bool isFullRange() const { return m_fullRange; }
+
+    // 转换整帧，尺寸和格式必须和init时一致
+    void convert(const AVFrame *frame, uint8_t *dst, int dstLinesize) const;
+
+private:
+    bool m_valid = false;
+    int m_width = 0;
+    int m_height = 0;
+    bool m_nv12 = false;
+    AVColorSpace m_colorspace = AVCOL_SPC_BT709;
+    bool m_fullRange = false;
+    // 输出每像素字节数；m_bgr表示第一个字节是B
+    int m_pixelBytes = 3;
+    bool m_bgr = false;
+    Kernel m_kernel = KernelScalar;
+    Coefficients m_coef = {};
+};
+
+#endif // YUVCONVERTER_H